@@ -0,0 +1,255 @@
+/*
+ * Benchmark.c
+ *
+ * simple timing of common BigInt workloads,
+ * used to compare different build configurations of BigInt.c
+ * (for instance with and without BIG_INT_SINGLE_ALLOCATION),
+ * followed by a table of multiplication times for increasing sizes and a multi-threaded stress test, the maximum number of threads can be passed as argument
+ * (the default is the number of available cores)
+ *
+ * Author: bsoelch
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "BigInt.h"
+
+static const int SMALL_VALUE_ITERATIONS = 2000000;
+static const int ACCUMULATE_ITERATIONS = 200000;
+static const int MULT_ITERATIONS = 200000;
+static const int CLONE_ITERATIONS = 1000000;
+static const int DIVIDE_ITERATIONS = 20;
+static const int STRESS_ITERATIONS = 20000;
+static const int STRING_DIGITS = 20000;
+//sizes (in bits) of the factors in the multiplication scaling table,
+//chosen to cover the schoolbook, Karatsuba, Toom-3 and Toom-4 multiplication
+static const int64_t SCALING_BITS[]={1000,4000,16000,32000,64000,128000,256000,1024000};
+
+typedef struct{
+	const char* name;
+	//runs the benchmark, returns a value derived from the result to prevent the compiler from skipping work
+	size_t (*run)(void);
+}Benchmark;
+
+//many short-lived 64bit values
+static size_t benchSmallValues(void){
+	BigInt* acc=createBigIntInt(0);
+	for(int64_t i=0;i<SMALL_VALUE_ITERATIONS;i++){
+		BigInt* x=multBigInt(createBigIntInt(i*7919),true,createBigIntInt(i&1023),true);
+		acc=addBigInt(acc,true,x,true);
+		acc=andBigInt(acc,true,createBigIntInt(0x7fffffffffffLL),true);
+	}
+	size_t ret=bigIntByteLength(acc,BIG_INT_BYTES_UNSIGNED);
+	freeBigInt(acc);
+	return ret;
+}
+//repeatedly growing a single number
+static size_t benchAccumulate(void){
+	BigInt* acc=createBigIntInt(1);
+	BigInt* summand=createBigIntInt(0x123456789abcdefLL);
+	for(int i=0;i<ACCUMULATE_ITERATIONS;i++){
+		acc=addBigInt(acc,true,summand,false);
+		if(i%16==0){
+			acc=shiftBigInt(acc,true,7);
+		}
+	}
+	size_t ret=bigIntByteLength(acc,BIG_INT_BYTES_UNSIGNED);
+	freeBigInt(summand);
+	freeBigInt(acc);
+	return ret;
+}
+//products of medium sized numbers (below the Karatsuba threshold)
+static size_t benchMultiply(void){
+	BigInt* a=shiftBigInt(createBigIntInt(0x76543210fedcbaLL),true,500);
+	BigInt* b=shiftBigInt(createBigIntInt(0x1234567LL),true,300);
+	size_t ret=0;
+	for(int i=0;i<MULT_ITERATIONS;i++){
+		BigInt* p=multBigInt(a,false,b,false);
+		ret+=bigIntByteLength(p,BIG_INT_BYTES_UNSIGNED);
+		freeBigInt(p);
+	}
+	freeBigInt(a);
+	freeBigInt(b);
+	return ret;
+}
+//division of large numbers (Karatsuba multiplication and Newton iteration)
+static size_t benchDivide(void){
+	BigInt* a=subtBigInt(shiftBigInt(createBigIntInt(0x7654321),true,96000),true,createBigIntInt(12345),true);
+	BigInt* b=subtBigInt(shiftBigInt(createBigIntInt(0x1234567),true,48000),true,createBigIntInt(67890),true);
+	size_t ret=0;
+	for(int i=0;i<DIVIDE_ITERATIONS;i++){
+		BigInt* q=divBigInt(a,false,b,false);
+		ret+=bigIntByteLength(q,BIG_INT_BYTES_UNSIGNED);
+		freeBigInt(q);
+	}
+	freeBigInt(a);
+	freeBigInt(b);
+	return ret;
+}
+//creating and freeing copies
+static size_t benchClone(void){
+	BigInt* a=shiftBigInt(createBigIntInt(0x55555555LL),true,200);
+	size_t ret=0;
+	for(int i=0;i<CLONE_ITERATIONS;i++){
+		BigInt* c=negateBigInt(cloneBigInt(a),true);
+		ret+=bigIntByteLength(c,BIG_INT_BYTES_UNSIGNED);
+		freeBigInt(c);
+	}
+	freeBigInt(a);
+	return ret;
+}
+//conversion from and to decimal strings
+static size_t benchStrings(void){
+	char* digits=malloc(STRING_DIGITS+1);
+	if(!digits){
+		return 0;
+	}
+	for(int i=0;i<STRING_DIGITS;i++){
+		digits[i]=(char)('1'+(i*7)%9);
+	}
+	digits[STRING_DIGITS]='\0';
+	BigInt* a=createBigIntCStr(digits,10);
+	free(digits);
+	char* str=bigIntToStringAlloc(a,true,10);
+	size_t ret=str?strlen(str):0;
+	free(str);
+	return ret;
+}
+
+static const Benchmark BENCHMARKS[]={
+		{"small values",&benchSmallValues},
+		{"accumulate",&benchAccumulate},
+		{"multiply",&benchMultiply},
+		{"divide",&benchDivide},
+		{"clone",&benchClone},
+		{"strings",&benchStrings},
+};
+
+//a pseudo-random number with (about) the given number of bits
+static BigInt* scalingValue(int64_t bits,int64_t seed){
+	BigInt* ret=createBigIntInt(1);
+	for(int64_t i=0;i<bits;i+=48){
+		seed=seed*6364136223846793005LL+1442695040888963407LL;
+		ret=addBigInt(shiftBigInt(ret,true,48),true,createBigIntInt((seed>>8)&0xffffffffffffLL),true);
+	}
+	return shiftBigInt(ret,true,-(int64_t)(bigIntByteLength(ret,BIG_INT_BYTES_UNSIGNED)*8-bits));
+}
+//times the multiplication and squaring of numbers of increasing size,
+//each size is repeated for at least 0.1s, the time per operation shows where the faster algorithms take over
+static void runMultiplyScaling(void){
+	printf("%10s %14s %14s\n","bits","mult [us]","square [us]");
+	for(size_t i=0;i<sizeof(SCALING_BITS)/sizeof(int64_t);i++){
+		BigInt* a=scalingValue(SCALING_BITS[i],1);
+		BigInt* b=scalingValue(SCALING_BITS[i],2);
+		double times[2];
+		for(int square=0;square<2;square++){
+			int iterations=0;
+			clock_t start=clock();
+			do{
+				freeBigInt(square?squareBigInt(a,false):multBigInt(a,false,b,false));
+				iterations++;
+			}while(clock()-start<CLOCKS_PER_SEC/10);
+			times[square]=(double)(clock()-start)/CLOCKS_PER_SEC/iterations*1e6;
+		}
+		printf("%10lld %14.1f %14.1f\n",(long long)SCALING_BITS[i],times[0],times[1]);
+		freeBigInt(a);
+		freeBigInt(b);
+	}
+}
+
+//mixed workload executed by every thread of the stress test,
+//uses the shared constants and the shared power cache together with the thread-local caches
+static void* stressWorker(void* arg){
+	size_t* check=arg;
+	BigInt* a=createBigIntCStr("123456789012345678901234567890123456789",10);
+	BigInt* m=createBigIntCStr("98765432109876543210987654321",10);
+	for(int i=0;i<STRESS_ITERATIONS;i++){
+		BigInt* x=addBigInt(addBigInt(a,false,createBigIntInt(i),true),true,BIG_INT_ONE,false);
+		BigInt* square=multBigInt(x,false,x,false);
+		freeBigInt(x);
+		x=modBigInt(square,true,m,false);
+		char* str=bigIntToStringAlloc(x,true,10);
+		*check+=str?strlen(str):0;
+		free(str);
+	}
+	freeBigInt(a);
+	freeBigInt(m);
+	return NULL;
+}
+static double wallTime(void){
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC,&time);
+	return time.tv_sec+time.tv_nsec*1e-9;
+}
+//runs the stress workload on 1,2,4,... up to maxThreads threads,
+//every thread does the same amount of work, so ideal scaling keeps the time constant
+static void runStressTest(int maxThreads){
+	pthread_t* threads=malloc(maxThreads*sizeof(pthread_t));
+	size_t* checks=calloc(maxThreads,sizeof(size_t));
+	if(!(threads&&checks)){
+		free(threads);
+		free(checks);
+		return;
+	}
+	double singleThroughput=0;
+	for(int numThreads=1;numThreads<=maxThreads;numThreads=(numThreads*2>maxThreads&&numThreads<maxThreads)?maxThreads:numThreads*2){
+		double start=wallTime();
+		int started=0;
+		for(;started<numThreads;started++){
+			checks[started]=0;
+			if(pthread_create(&threads[started],NULL,&stressWorker,&checks[started])!=0){
+				break;
+			}
+		}
+		for(int i=0;i<started;i++){
+			pthread_join(threads[i],NULL);
+		}
+		double time=wallTime()-start;
+		double throughput=started*(double)STRESS_ITERATIONS/time;
+		if(numThreads==1){
+			singleThroughput=throughput;
+		}
+		printf("stress %3d threads %8.3fs %12.0f ops/s  speedup %5.2f  (check: %zu)\n",started,time,
+				throughput,throughput/singleThroughput,checks[0]);
+	}
+	free(threads);
+	free(checks);
+}
+
+int main(int argc,char** argv){
+	int maxThreads=argc>1?atoi(argv[1]):(int)sysconf(_SC_NPROCESSORS_ONLN);
+	if(maxThreads<1){
+		maxThreads=1;
+	}
+	if(argc>2&&!bigIntSetKernels(argv[2])){
+		printf("kernels \"%s\" are not available\n",argv[2]);
+		return 1;
+	}
+#ifdef BIG_INT_SINGLE_ALLOCATION
+	printf("layout: single allocation\n");
+#else
+	printf("layout: separate data\n");
+#endif
+	printf("kernels: %s\n",bigIntKernels());
+	for(size_t i=0;i<sizeof(BENCHMARKS)/sizeof(Benchmark);i++){
+		clock_t start=clock();
+		size_t check=BENCHMARKS[i].run();
+		double time=(double)(clock()-start)/CLOCKS_PER_SEC;
+		printf("%-14s %8.3fs  (check: %zu)\n",BENCHMARKS[i].name,time,check);
+	}
+	runMultiplyScaling();
+	BigIntCacheStats stats=bigIntCacheStats();
+	printf("block cache: %zu hits, %zu misses, %zu bytes retained\n",stats.hits,stats.misses,stats.retainedBytes);
+	//only prints something if BigInt.c is compiled with BIG_INT_PROFILE
+	if(bigIntWriteProfile(stdout,BIG_INT_PROFILE_TEXT)){
+		bigIntResetProfile();
+	}
+	runStressTest(maxThreads);
+	bigIntFreePowerCache();
+	return 0;
+}
@@ -5,88 +5,1714 @@
  *  Author: bsoelch
  */
 #include <stdlib.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <string.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <assert.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
 
 #include "BigInt.h"
 
+//if BIG_INT_64BIT_LIMBS is defined the digits of the numbers are stored in 64bit ints
+//and products are computed with (compiler provided) 128bit ints,
+//otherwise 32bit ints with 64bit products are used
+#ifdef BIG_INT_64BIT_LIMBS
+#ifndef __SIZEOF_INT128__
+#error "BIG_INT_64BIT_LIMBS needs a compiler with 128bit integers"
+#endif
+typedef uint64_t Limb;
+typedef unsigned __int128 DoubleLimb;
+#define LIMB_MAX UINT64_MAX
+static const int INT_BITS = 64;
+#else
+typedef uint32_t Limb;
+typedef uint64_t DoubleLimb;
+#define LIMB_MAX UINT32_MAX
 static const int INT_BITS = 32;
+#endif
+//the x86-64 kernels (mulx from BMI2, adcx/adox from ADX) work on 64bit ints
+#if defined(BIG_INT_64BIT_LIMBS)&&defined(__x86_64__)&&defined(__GNUC__)
+#define BIG_INT_X86_KERNELS
+#include <cpuid.h>
+#endif
 //TODO add int-pointer errorCode parameter to functions
 
+//default values of the algorithm thresholds, can be replaced at compile time by defining the macros
+//or with the header generated by Tune.c, the values used by the operations are set with bigIntSetThreshold
+#ifdef BIG_INT_TUNED
+#include "BigIntThresholds.h"
+#endif
 //value for switching from standard multiplication to Karatsuba-algorithm
 //(small) experiment points to values between 20 and 40 being the best
-static const size_t KARATSUBA_THRESHOLD = 30;
+#ifndef BIG_INT_KARATSUBA_THRESHOLD
+#define BIG_INT_KARATSUBA_THRESHOLD 30
+#endif
+//value for switching from the schoolbook squaring to the Karatsuba squaring,
+//the schoolbook squaring only computes half of the products so the threshold is higher
+#ifndef BIG_INT_KARATSUBA_SQR_THRESHOLD
+#define BIG_INT_KARATSUBA_SQR_THRESHOLD 60
+#endif
+//values for switching from Karatsuba to the Toom-Cook 3-way and 4-way algorithms,
+//both factors need to have at least this many ints,
+//Toom-3 is faster than Karatsuba above 300-400 ints, Toom-4 gains a few percent above 1000 ints
+#ifndef BIG_INT_TOOM3_THRESHOLD
+#define BIG_INT_TOOM3_THRESHOLD 300
+#endif
+#ifndef BIG_INT_TOOM4_THRESHOLD
+#define BIG_INT_TOOM4_THRESHOLD 1000
+#endif
+#ifndef BIG_INT_TOOM3_SQR_THRESHOLD
+#define BIG_INT_TOOM3_SQR_THRESHOLD 300
+#endif
+#ifndef BIG_INT_TOOM4_SQR_THRESHOLD
+#define BIG_INT_TOOM4_SQR_THRESHOLD 1000
+#endif
+//value for switching from Karatsuba to the unbalanced Toom-3.2 algorithm (the larger factor split into three parts,
+//the smaller one into two), used if the smaller factor has at least this many ints
+//and the larger one is between 1.5 and 2 times as long
+#ifndef BIG_INT_TOOM32_THRESHOLD
+#define BIG_INT_TOOM32_THRESHOLD 100
+#endif
+//values for switching to the multiplication with number theoretic transforms,
+//used if the smaller factor has at least this many ints and the product is small enough for the transform,
+//the transform works on 32bit pieces, so the crossover with Toom-4 depends on the size of the ints:
+//around 4000 32bit ints and around 32000 (40000 for squares) 64bit ints,
+//the time of the transform grows in steps at powers of 2, so it wins just below them and loses just above them
+#ifndef BIG_INT_NTT_THRESHOLD
+#ifdef BIG_INT_64BIT_LIMBS
+#define BIG_INT_NTT_THRESHOLD 32000
+#else
+#define BIG_INT_NTT_THRESHOLD 4000
+#endif
+#endif
+#ifndef BIG_INT_NTT_SQR_THRESHOLD
+#ifdef BIG_INT_64BIT_LIMBS
+#define BIG_INT_NTT_SQR_THRESHOLD 40000
+#else
+#define BIG_INT_NTT_SQR_THRESHOLD 4000
+#endif
+#endif
+//divisions are computed with the Newton-algorithm if both the divisor and the quotient
+//have more than this many ints, otherwise the schoolbook division is used,
+//the Newton iteration runs at full precision, so the schoolbook division is faster
+//up to about 28000 32bit ints and between 48000 and 64000 64bit ints
+#ifndef BIG_INT_NEWTON_DIV_THRESHOLD
+#ifdef BIG_INT_64BIT_LIMBS
+#define BIG_INT_NEWTON_DIV_THRESHOLD 56000
+#else
+#define BIG_INT_NEWTON_DIV_THRESHOLD 28000
+#endif
+#endif
+//number of digits above which strings are parsed with the divide and conquer algorithm
+#ifndef BIG_INT_PARSE_DC_THRESHOLD
+#define BIG_INT_PARSE_DC_THRESHOLD 1000
+#endif
+//minimum size (in ints) of a number before its conversion to a string is split between multiple threads
+#ifndef BIG_INT_PARALLEL_PRINT_THRESHOLD
+#define BIG_INT_PARALLEL_PRINT_THRESHOLD 2000
+#endif
+
+typedef struct{
+	const char* name;
+	size_t defaultValue;
+	//smallest value the algorithms can handle
+	size_t minValue;
+}ThresholdInfo;
+static const ThresholdInfo internal_thresholdInfo[BIG_INT_THRESHOLD_COUNT]={
+		[BIG_INT_THRESHOLD_KARATSUBA]={"karatsuba",BIG_INT_KARATSUBA_THRESHOLD,4},
+		[BIG_INT_THRESHOLD_KARATSUBA_SQR]={"karatsubaSqr",BIG_INT_KARATSUBA_SQR_THRESHOLD,4},
+		//from these sizes on all parts of balanced Toom-3 and Toom-4 factors are non-empty
+		[BIG_INT_THRESHOLD_TOOM3]={"toom3",BIG_INT_TOOM3_THRESHOLD,5},
+		[BIG_INT_THRESHOLD_TOOM3_SQR]={"toom3Sqr",BIG_INT_TOOM3_SQR_THRESHOLD,5},
+		[BIG_INT_THRESHOLD_TOOM4]={"toom4",BIG_INT_TOOM4_THRESHOLD,10},
+		[BIG_INT_THRESHOLD_TOOM4_SQR]={"toom4Sqr",BIG_INT_TOOM4_SQR_THRESHOLD,10},
+		[BIG_INT_THRESHOLD_TOOM32]={"toom32",BIG_INT_TOOM32_THRESHOLD,1},
+		[BIG_INT_THRESHOLD_NTT]={"ntt",BIG_INT_NTT_THRESHOLD,1},
+		[BIG_INT_THRESHOLD_NTT_SQR]={"nttSqr",BIG_INT_NTT_SQR_THRESHOLD,1},
+		[BIG_INT_THRESHOLD_NEWTON_DIV]={"newtonDiv",BIG_INT_NEWTON_DIV_THRESHOLD,1},
+		//the divide and conquer parsing needs strings longer than the digits of one int
+		[BIG_INT_THRESHOLD_PARSE_DC]={"parseDC",BIG_INT_PARSE_DC_THRESHOLD,64},
+		[BIG_INT_THRESHOLD_PARALLEL_PRINT]={"parallelPrint",BIG_INT_PARALLEL_PRINT_THRESHOLD,1},
+};
+//current values of the thresholds, 0 stands for the default value
+static atomic_size_t internal_thresholds[BIG_INT_THRESHOLD_COUNT];
+
+static inline size_t internal_threshold(BigIntThreshold threshold){
+	size_t value=atomic_load_explicit(&internal_thresholds[threshold],memory_order_relaxed);
+	return value?value:internal_thresholdInfo[threshold].defaultValue;
+}
+#define KARATSUBA_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_KARATSUBA)
+#define KARATSUBA_SQR_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_KARATSUBA_SQR)
+#define TOOM3_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_TOOM3)
+#define TOOM3_SQR_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_TOOM3_SQR)
+#define TOOM4_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_TOOM4)
+#define TOOM4_SQR_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_TOOM4_SQR)
+#define TOOM32_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_TOOM32)
+#define NTT_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_NTT)
+#define NTT_SQR_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_NTT_SQR)
+#define NEWTON_DIV_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_NEWTON_DIV)
+#define PARSE_DC_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_PARSE_DC)
+#define PARALLEL_PRINT_THRESHOLD internal_threshold(BIG_INT_THRESHOLD_PARALLEL_PRINT)
+
+/**name of the threshold (e.g. "karatsuba" for BIG_INT_THRESHOLD_KARATSUBA)*/
+const char* bigIntThresholdName(BigIntThreshold threshold){
+	return threshold>=0&&threshold<BIG_INT_THRESHOLD_COUNT?internal_thresholdInfo[threshold].name:"unknown";
+}
+/**sets the value of threshold, 0 restores the compiled default,
+ * returns false if threshold does not exist or value is below the smallest supported value
+ * (the threshold is not changed in that case)*/
+bool bigIntSetThreshold(BigIntThreshold threshold,size_t value){
+	if(threshold<0||threshold>=BIG_INT_THRESHOLD_COUNT||(value!=0&&value<internal_thresholdInfo[threshold].minValue)){
+		return false;
+	}
+	atomic_store_explicit(&internal_thresholds[threshold],value,memory_order_relaxed);
+	return true;
+}
+/**current value of threshold, 0 if threshold does not exist*/
+size_t bigIntThreshold(BigIntThreshold threshold){
+	return threshold>=0&&threshold<BIG_INT_THRESHOLD_COUNT?internal_threshold(threshold):0;
+}
 
 static const int BIGINT_MAX_BASE = 62;
 
 //TODO memory cleanup if one of the arguments is NULL
 
+//number of ints that are stored directly in the BigInt instead of a separate memory block
+#define BIG_INT_INLINE_SIZE 2
+//if BIG_INT_SINGLE_ALLOCATION is defined the header and the data of every BigInt
+//are stored in a single memory block, growing a number then may move the whole BigInt
+
 typedef struct BigIntStruct{
-	//sgn data (0 if this number is >=0, UINT32_MAX if number is <0)
-	uint32_t sgn;
-	//addLater allow capacity>size
+	//context that allocated the memory of this number, used for all later (re-)allocations
+	BigIntContext* context;
+	//sgn data (0 if this number is >=0, LIMB_MAX if number is <0)
+	Limb sgn;
+	//number of ints used by this number
 	size_t size;
+	//number of ints that fit in data without reallocation (capacity>=size)
+	size_t capacity;
 	//unsigned bit-data of this number (in little endian notation)
-	uint32_t* data;//addLater? handle BigEndian encodings
+	//points to inlineData as long as the number fits into BIG_INT_INLINE_SIZE ints
+	//(or always if BIG_INT_SINGLE_ALLOCATION is defined)
+	Limb* data;//addLater? handle BigEndian encodings
+#ifdef BIG_INT_SINGLE_ALLOCATION
+	//data of this number, allocated together with the header
+	Limb inlineData[];
+#else
+	//storage for small numbers, avoids a second allocation for all 64bit values
+	Limb inlineData[BIG_INT_INLINE_SIZE];
+#endif
 }BigInt;
 
+static void* internal_mallocAllocate(void* userData,size_t size){
+	(void)userData;
+	return malloc(size);
+}
+static void* internal_mallocReallocate(void* userData,void* ptr,size_t oldSize,size_t newSize){
+	(void)userData;
+	(void)oldSize;
+	return realloc(ptr,newSize);
+}
+static void internal_mallocRelease(void* userData,void* ptr,size_t size){
+	(void)userData;
+	(void)size;
+	free(ptr);
+}
+//context using malloc, realloc and free
+static BigIntContext internal_defaultContext={
+		.allocate=&internal_mallocAllocate,
+		.reallocate=&internal_mallocReallocate,
+		.release=&internal_mallocRelease,
+		.userData=NULL
+};
+//context used for new numbers created by the current thread
+static _Thread_local BigIntContext* internal_currentContext=&internal_defaultContext;
+
+/**sets the context used to allocate the numbers created by the calling thread,
+ * NULL selects the default context (malloc), returns the previous context*/
+BigIntContext* bigIntSetContext(BigIntContext* context){
+	BigIntContext* prev=internal_currentContext;
+	internal_currentContext=context?context:&internal_defaultContext;
+	return prev==&internal_defaultContext?NULL:prev;
+}
+/**returns the context used by the calling thread, NULL if the thread uses the default context*/
+BigIntContext* bigIntGetContext(void){
+	return internal_currentContext==&internal_defaultContext?NULL:internal_currentContext;
+}
+
+//the default context is called directly to avoid the indirection on the most common path
+static inline void* internal_allocate(BigIntContext* context,size_t size){
+	if(context==&internal_defaultContext){
+		return malloc(size);
+	}
+	return context->allocate(context->userData,size);
+}
+static inline void* internal_reallocate(BigIntContext* context,void* ptr,size_t oldSize,size_t newSize){
+	if(context==&internal_defaultContext){
+		return realloc(ptr,newSize);
+	}
+	return context->reallocate(context->userData,ptr,oldSize,newSize);
+}
+static inline void internal_release(BigIntContext* context,void* ptr,size_t size){
+	if(context==&internal_defaultContext){
+		free(ptr);
+	}else{
+		context->release(context->userData,ptr,size);
+	}
+}
+
+//alignment of all allocations in an arena
+#define BIG_INT_ARENA_ALIGN 16
+
+typedef struct ArenaBlockStruct{
+	struct ArenaBlockStruct* next;
+	//number of usable bytes in data
+	size_t size;
+	_Alignas(BIG_INT_ARENA_ALIGN) unsigned char data[];
+}ArenaBlock;
+
+struct BigIntArenaStruct{
+	//context that allocates from this arena, context.userData points to the arena
+	BigIntContext context;
+	//first block of the arena, blocks are kept in a list and reused after a reset
+	ArenaBlock* first;
+	ArenaBlock* current;
+	//number of used bytes in the current block
+	size_t offset;
+	//most recent allocation, the only one that can be resized or released in place
+	unsigned char* last;
+	//minimum size of newly allocated blocks
+	size_t blockSize;
+};
+
+static ArenaBlock* internal_createArenaBlock(size_t size){
+	ArenaBlock* block=malloc(sizeof(ArenaBlock)+size);
+	if(block){
+		block->next=NULL;
+		block->size=size;
+	}
+	return block;
+}
+static void* internal_arenaAllocate(void* userData,size_t size){
+	BigIntArena* arena=userData;
+	size=(size+BIG_INT_ARENA_ALIGN-1)&~(size_t)(BIG_INT_ARENA_ALIGN-1);
+	if(size>arena->current->size-arena->offset){
+		//continue in the next block that is large enough, blocks that are too small stay unused until the next reset
+		ArenaBlock* prev=arena->current;
+		ArenaBlock* next=prev->next;
+		while(next&&next->size<size){
+			prev=next;
+			next=next->next;
+		}
+		if(!next){
+			next=internal_createArenaBlock(size>arena->blockSize?size:arena->blockSize);
+			if(!next){
+				return NULL;
+			}
+			prev->next=next;
+		}
+		arena->current=next;
+		arena->offset=0;
+	}
+	arena->last=arena->current->data+arena->offset;
+	arena->offset+=size;
+	return arena->last;
+}
+static void* internal_arenaReallocate(void* userData,void* ptr,size_t oldSize,size_t newSize){
+	BigIntArena* arena=userData;
+	if(ptr!=NULL&&ptr==arena->last){
+		//the most recent allocation can grow in place
+		size_t start=arena->last-arena->current->data;
+		size_t size=(newSize+BIG_INT_ARENA_ALIGN-1)&~(size_t)(BIG_INT_ARENA_ALIGN-1);
+		if(size<=arena->current->size-start){
+			arena->offset=start+size;
+			return ptr;
+		}
+	}
+	void* ret=internal_arenaAllocate(arena,newSize);
+	if(ret&&ptr){
+		memcpy(ret,ptr,oldSize<newSize?oldSize:newSize);
+	}
+	return ret;
+}
+static void internal_arenaRelease(void* userData,void* ptr,size_t size){
+	(void)size;
+	BigIntArena* arena=userData;
+	if(ptr!=NULL&&ptr==arena->last){
+		//memory of the most recent allocation can be reused directly
+		arena->offset=arena->last-arena->current->data;
+		arena->last=NULL;
+	}
+	//all other memory is only released by bigIntArenaReset
+}
+
+/**creates an arena that allocates memory in blocks of (at least) blockSize bytes,
+ * returns NULL if the allocation failed*/
+BigIntArena* createBigIntArena(size_t blockSize){
+	if(blockSize<4096){
+		blockSize=4096;
+	}
+	BigIntArena* arena=malloc(sizeof(BigIntArena));
+	if(arena){
+		arena->first=internal_createArenaBlock(blockSize);
+		if(!arena->first){
+			free(arena);
+			return NULL;
+		}
+		arena->context=(BigIntContext){
+			.allocate=&internal_arenaAllocate,
+			.reallocate=&internal_arenaReallocate,
+			.release=&internal_arenaRelease,
+			.userData=arena
+		};
+		arena->current=arena->first;
+		arena->offset=0;
+		arena->last=NULL;
+		arena->blockSize=blockSize;
+	}
+	return arena;
+}
+/**returns the context allocating from arena*/
+BigIntContext* bigIntArenaContext(BigIntArena* arena){
+	return arena?&arena->context:NULL;
+}
+/**releases all numbers allocated from arena at once,
+ * the memory blocks of the arena are kept and reused for later allocations*/
+void bigIntArenaReset(BigIntArena* arena){
+	if(arena){
+		arena->current=arena->first;
+		arena->offset=0;
+		arena->last=NULL;
+	}
+}
+/**frees the arena and all numbers allocated from it*/
+void freeBigIntArena(BigIntArena* arena){
+	if(arena){
+		if(internal_currentContext==&arena->context){
+			internal_currentContext=&internal_defaultContext;
+		}
+		ArenaBlock* block=arena->first;
+		while(block){
+			ArenaBlock* next=block->next;
+			free(block);
+			block=next;
+		}
+		free(arena);
+	}
+}
+
+static const char* const internal_operationNames[BIG_INT_OP_COUNT]={
+		[BIG_INT_OP_OTHER]="other",
+		[BIG_INT_OP_PARSE]="createBigIntStr",
+		[BIG_INT_OP_TO_STRING]="bigIntToString",
+		[BIG_INT_OP_PRINT]="printBigInt",
+		[BIG_INT_OP_NOT]="notBigInt",
+		[BIG_INT_OP_AND]="andBigInt",
+		[BIG_INT_OP_OR]="orBigInt",
+		[BIG_INT_OP_XOR]="xorBigInt",
+		[BIG_INT_OP_SHIFT]="shiftBigInt",
+		[BIG_INT_OP_NEGATE]="negateBigInt",
+		[BIG_INT_OP_ADD]="addBigInt",
+		[BIG_INT_OP_SUBT]="subtBigInt",
+		[BIG_INT_OP_MULT]="multBigInt",
+		[BIG_INT_OP_SQUARE]="squareBigInt",
+		[BIG_INT_OP_DIVMOD]="divModBigInt",
+		[BIG_INT_OP_GCD]="bigIntGCD",
+		[BIG_INT_OP_POW]="powBigInt",
+};
+/**name of the function corresponding to op*/
+const char* bigIntOperationName(BigIntOperation op){
+	return op>=0&&op<BIG_INT_OP_COUNT?internal_operationNames[op]:"unknown";
+}
+
+//algorithms and special cases selected by the operations, counted if BIG_INT_PROFILE is defined
+typedef enum{
+	BRANCH_MULT_SCHOOLBOOK,
+	BRANCH_MULT_KARATSUBA,
+	BRANCH_MULT_TOOM3,
+	BRANCH_MULT_TOOM4,
+	BRANCH_MULT_NTT,
+	BRANCH_MULT_TOOM32,
+	//larger factor split into parts of the size of the smaller one
+	BRANCH_MULT_UNBALANCED,
+	BRANCH_SQUARE_SCHOOLBOOK,
+	BRANCH_SQUARE_KARATSUBA,
+	BRANCH_SQUARE_TOOM3,
+	BRANCH_SQUARE_TOOM4,
+	BRANCH_SQUARE_NTT,
+	//divisor with a single int
+	BRANCH_DIV_SINGLE_INT,
+	BRANCH_DIV_NEWTON,
+	//number of iterations of the Newton-approximation
+	BRANCH_DIV_NEWTON_ITERATIONS,
+	BRANCH_DIV_LONG,
+	//dividend smaller than the divisor
+	BRANCH_DIV_SMALL_DIVIDEND,
+	BRANCH_PARSE_POW2,
+	//blocks of at most PARSE_DC_THRESHOLD digits converted directly
+	BRANCH_PARSE_BLOCKS,
+	BRANCH_PARSE_SPLIT,
+	BRANCH_PRINT_POW2,
+	//parts with at most 64 bits printed directly
+	BRANCH_PRINT_INT64,
+	BRANCH_PRINT_SPLIT,
+	//parts printed by an additional thread
+	BRANCH_PRINT_THREAD,
+	BRANCH_COUNT
+}ProfileBranch;
+
+#ifdef BIG_INT_PROFILE
+static const char* const internal_branchNames[BRANCH_COUNT]={
+		[BRANCH_MULT_SCHOOLBOOK]="mult.schoolbook",
+		[BRANCH_MULT_KARATSUBA]="mult.karatsuba",
+		[BRANCH_MULT_TOOM3]="mult.toom3",
+		[BRANCH_MULT_TOOM4]="mult.toom4",
+		[BRANCH_MULT_NTT]="mult.ntt",
+		[BRANCH_MULT_TOOM32]="mult.toom32",
+		[BRANCH_MULT_UNBALANCED]="mult.unbalanced",
+		[BRANCH_SQUARE_SCHOOLBOOK]="square.schoolbook",
+		[BRANCH_SQUARE_KARATSUBA]="square.karatsuba",
+		[BRANCH_SQUARE_TOOM3]="square.toom3",
+		[BRANCH_SQUARE_TOOM4]="square.toom4",
+		[BRANCH_SQUARE_NTT]="square.ntt",
+		[BRANCH_DIV_SINGLE_INT]="divMod.singleInt",
+		[BRANCH_DIV_NEWTON]="divMod.newton",
+		[BRANCH_DIV_NEWTON_ITERATIONS]="divMod.newtonIterations",
+		[BRANCH_DIV_LONG]="divMod.long",
+		[BRANCH_DIV_SMALL_DIVIDEND]="divMod.smallDividend",
+		[BRANCH_PARSE_POW2]="parse.pow2",
+		[BRANCH_PARSE_BLOCKS]="parse.blocks",
+		[BRANCH_PARSE_SPLIT]="parse.split",
+		[BRANCH_PRINT_POW2]="print.pow2",
+		[BRANCH_PRINT_INT64]="print.int64",
+		[BRANCH_PRINT_SPLIT]="print.split",
+		[BRANCH_PRINT_THREAD]="print.thread",
+};
+
+//bucket k of the operand size histograms counts operands with 2^(k-1) <= size < 2^k
+#define BIG_INT_PROFILE_BUCKETS 40
+
+typedef struct{
+	atomic_size_t calls[BIG_INT_OP_COUNT];
+	atomic_size_t nanos[BIG_INT_OP_COUNT];
+	atomic_size_t sizes[BIG_INT_OP_COUNT][BIG_INT_PROFILE_BUCKETS];
+	atomic_size_t branches[BRANCH_COUNT];
+}ProfileCounters;
+#endif
+
+//statistics of a single thread, only written by the owning thread,
+//the other threads read them (with relaxed atomics) when a snapshot is taken
+typedef struct ThreadStatsStruct{
+	atomic_size_t allocations;
+	atomic_size_t reallocations;
+	atomic_size_t frees;
+	//the numbers of a thread can be released by another thread,
+	//so the live bytes of a single thread are interpreted as signed value
+	atomic_size_t liveBytes;
+	atomic_size_t peakBytes;
+	atomic_size_t opAllocations[BIG_INT_OP_COUNT];
+	atomic_size_t opBytes[BIG_INT_OP_COUNT];
+#ifdef BIG_INT_PROFILE
+	ProfileCounters profile;
+#endif
+	struct ThreadStatsStruct* next;
+	bool registered;
+}ThreadStats;
+
+static atomic_bool internal_memoryStatsEnabled;
+static _Thread_local ThreadStats internal_threadStats;
+//all threads that have counted statistics, the counters of terminated threads are merged into
+//internal_retiredMemoryStats and internal_retiredProfile
+static ThreadStats* internal_statsThreads;
+static BigIntMemoryStats internal_retiredMemoryStats;
+#ifdef BIG_INT_PROFILE
+static ProfileCounters internal_retiredProfile;
+#endif
+static pthread_mutex_t internal_statsLock=PTHREAD_MUTEX_INITIALIZER;
+static pthread_key_t internal_statsKey;
+static pthread_once_t internal_statsKeyOnce=PTHREAD_ONCE_INIT;
+
+//adds the memory counters of stats to target
+static void internal_addMemoryStats(BigIntMemoryStats* target,ThreadStats* stats){
+	target->allocations+=atomic_load_explicit(&stats->allocations,memory_order_relaxed);
+	target->reallocations+=atomic_load_explicit(&stats->reallocations,memory_order_relaxed);
+	target->frees+=atomic_load_explicit(&stats->frees,memory_order_relaxed);
+	target->liveBytes+=atomic_load_explicit(&stats->liveBytes,memory_order_relaxed);
+	target->peakBytes+=atomic_load_explicit(&stats->peakBytes,memory_order_relaxed);
+	for(int op=0;op<BIG_INT_OP_COUNT;op++){
+		target->opAllocations[op]+=atomic_load_explicit(&stats->opAllocations[op],memory_order_relaxed);
+		target->opBytes[op]+=atomic_load_explicit(&stats->opBytes[op],memory_order_relaxed);
+	}
+}
+#ifdef BIG_INT_PROFILE
+//adds each counter of source to the corresponding counter of target (or sets it if add is false),
+//source NULL sets all counters to zero
+static void internal_mergeProfile(ProfileCounters* target,ProfileCounters* source,bool add){
+	atomic_size_t* t=(atomic_size_t*)target;
+	atomic_size_t* s=(atomic_size_t*)source;
+	for(size_t i=0;i<sizeof(ProfileCounters)/sizeof(atomic_size_t);i++){
+		size_t value=s?atomic_load_explicit(&s[i],memory_order_relaxed):0;
+		if(add){
+			value+=atomic_load_explicit(&t[i],memory_order_relaxed);
+		}
+		atomic_store_explicit(&t[i],value,memory_order_relaxed);
+	}
+}
+#endif
+static void internal_statsDestructor(void* data){
+	ThreadStats* stats=data;
+	//the destructor of the block cache may run after this one,
+	//release the cache first so that freeing the scratch buffer is still counted by this thread
+	bigIntReleaseThreadCache();
+	pthread_mutex_lock(&internal_statsLock);
+	internal_addMemoryStats(&internal_retiredMemoryStats,stats);
+#ifdef BIG_INT_PROFILE
+	internal_mergeProfile(&internal_retiredProfile,&stats->profile,true);
+#endif
+	ThreadStats** prev=&internal_statsThreads;
+	while(*prev!=stats){
+		prev=&(*prev)->next;
+	}
+	*prev=stats->next;
+	pthread_mutex_unlock(&internal_statsLock);
+	//the counters are part of the retired statistics now,
+	//a later allocation of this thread registers it again with new counters
+	memset(stats,0,sizeof(ThreadStats));
+}
+static void internal_createStatsKey(void){
+	pthread_key_create(&internal_statsKey,&internal_statsDestructor);
+}
+//returns the statistics of the calling thread
+static inline ThreadStats* internal_getThreadStats(void){
+	ThreadStats* stats=&internal_threadStats;
+	if(!stats->registered){
+		pthread_once(&internal_statsKeyOnce,&internal_createStatsKey);
+		pthread_mutex_lock(&internal_statsLock);
+		stats->next=internal_statsThreads;
+		internal_statsThreads=stats;
+		pthread_mutex_unlock(&internal_statsLock);
+		pthread_setspecific(internal_statsKey,stats);
+		stats->registered=true;
+	}
+	return stats;
+}
+//returns the statistics of the calling thread, or NULL if the memory statistics are disabled
+static inline ThreadStats* internal_memoryStats(void){
+	if(!atomic_load_explicit(&internal_memoryStatsEnabled,memory_order_relaxed)){
+		return NULL;
+	}
+	return internal_getThreadStats();
+}
+//the counters are only written by their own thread, so no atomic read-modify-write is needed
+static inline void internal_statAdd(atomic_size_t* counter,size_t value){
+	atomic_store_explicit(counter,atomic_load_explicit(counter,memory_order_relaxed)+value,memory_order_relaxed);
+}
+
+//public operation executed by the current thread, the outermost one if operations call each other
+static _Thread_local BigIntOperation internal_currentOp=BIG_INT_OP_OTHER;
+
+//state of an operation between internal_enterOp and internal_leaveOp
+typedef struct{
+	BigIntOperation prev;
+#ifdef BIG_INT_PROFILE
+	BigIntOperation op;
+	struct timespec start;
+#endif
+}OperationScope;
+
+#ifdef BIG_INT_PROFILE
+static inline void internal_profileBranch(ProfileBranch branch){
+	internal_statAdd(&internal_getThreadStats()->profile.branches[branch],1);
+}
+#else
+static inline void internal_profileBranch(ProfileBranch branch){
+	(void)branch;
+}
+#endif
+
+//marks the start of the public operation op with the given operand size (in ints),
+//returns the value that has to be passed to internal_leaveOp
+static inline OperationScope internal_enterOp(BigIntOperation op,size_t operandSize){
+	OperationScope scope={.prev=internal_currentOp};
+	if(scope.prev==BIG_INT_OP_OTHER){
+		internal_currentOp=op;
+	}
+#ifdef BIG_INT_PROFILE
+	ProfileCounters* profile=&internal_getThreadStats()->profile;
+	int bucket=0;
+	while(bucket<BIG_INT_PROFILE_BUCKETS-1&&operandSize>=((size_t)1<<bucket)){
+		bucket++;
+	}
+	internal_statAdd(&profile->calls[op],1);
+	internal_statAdd(&profile->sizes[op][bucket],1);
+	scope.op=op;
+	clock_gettime(CLOCK_MONOTONIC,&scope.start);
+#else
+	(void)operandSize;
+#endif
+	return scope;
+}
+static inline void internal_leaveOp(OperationScope scope){
+#ifdef BIG_INT_PROFILE
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC,&end);
+	internal_statAdd(&internal_getThreadStats()->profile.nanos[scope.op],
+			(end.tv_sec-scope.start.tv_sec)*1000000000LL+(end.tv_nsec-scope.start.tv_nsec));
+#endif
+	internal_currentOp=scope.prev;
+}
+//operand size of an operation with the arguments a and b (b can be NULL)
+static inline size_t internal_operandSize(BigInt* a,BigInt* b){
+	size_t size=a?a->size:0;
+	if(b&&b->size>size){
+		size=b->size;
+	}
+	return size;
+}
+
+static void internal_statLiveBytes(ThreadStats* stats,size_t added,size_t removed){
+	size_t live=atomic_load_explicit(&stats->liveBytes,memory_order_relaxed)+added-removed;
+	atomic_store_explicit(&stats->liveBytes,live,memory_order_relaxed);
+	if((ptrdiff_t)live>(ptrdiff_t)atomic_load_explicit(&stats->peakBytes,memory_order_relaxed)){
+		atomic_store_explicit(&stats->peakBytes,live,memory_order_relaxed);
+	}
+}
+//counts a new memory block with the given size
+static inline void internal_countAllocation(size_t bytes){
+	ThreadStats* stats=internal_memoryStats();
+	if(stats){
+		internal_statAdd(&stats->allocations,1);
+		internal_statAdd(&stats->opAllocations[internal_currentOp],1);
+		internal_statAdd(&stats->opBytes[internal_currentOp],bytes);
+		internal_statLiveBytes(stats,bytes,0);
+	}
+}
+//counts the resizing of a memory block
+static inline void internal_countReallocation(size_t oldBytes,size_t newBytes){
+	ThreadStats* stats=internal_memoryStats();
+	if(stats){
+		internal_statAdd(&stats->reallocations,1);
+		internal_statAdd(&stats->opAllocations[internal_currentOp],1);
+		internal_statAdd(&stats->opBytes[internal_currentOp],newBytes>oldBytes?newBytes-oldBytes:0);
+		internal_statLiveBytes(stats,newBytes,oldBytes);
+	}
+}
+//counts the release of a memory block with the given size
+static inline void internal_countFree(size_t bytes){
+	ThreadStats* stats=internal_memoryStats();
+	if(stats){
+		internal_statAdd(&stats->frees,1);
+		internal_statLiveBytes(stats,0,bytes);
+	}
+}
+
+/**enables or disables the memory statistics*/
+void bigIntEnableMemoryStats(bool enable){
+	atomic_store(&internal_memoryStatsEnabled,enable);
+}
+/**returns the memory statistics summed over all threads*/
+BigIntMemoryStats bigIntMemoryStats(void){
+	BigIntMemoryStats ret;
+	pthread_mutex_lock(&internal_statsLock);
+	ret=internal_retiredMemoryStats;
+	for(ThreadStats* stats=internal_statsThreads;stats;stats=stats->next){
+		internal_addMemoryStats(&ret,stats);
+	}
+	pthread_mutex_unlock(&internal_statsLock);
+	//memory allocated before the statistics were enabled can make the sum negative
+	if((ptrdiff_t)ret.liveBytes<0){
+		ret.liveBytes=0;
+	}
+	if((ptrdiff_t)ret.peakBytes<(ptrdiff_t)ret.liveBytes){
+		ret.peakBytes=ret.liveBytes;
+	}
+	return ret;
+}
+/**sets all counters except liveBytes to zero*/
+void bigIntResetMemoryStats(void){
+	pthread_mutex_lock(&internal_statsLock);
+	size_t live=internal_retiredMemoryStats.liveBytes;
+	internal_retiredMemoryStats=(BigIntMemoryStats){.liveBytes=live,.peakBytes=live};
+	for(ThreadStats* stats=internal_statsThreads;stats;stats=stats->next){
+		atomic_store_explicit(&stats->allocations,0,memory_order_relaxed);
+		atomic_store_explicit(&stats->reallocations,0,memory_order_relaxed);
+		atomic_store_explicit(&stats->frees,0,memory_order_relaxed);
+		atomic_store_explicit(&stats->peakBytes,atomic_load_explicit(&stats->liveBytes,memory_order_relaxed),memory_order_relaxed);
+		for(int op=0;op<BIG_INT_OP_COUNT;op++){
+			atomic_store_explicit(&stats->opAllocations[op],0,memory_order_relaxed);
+			atomic_store_explicit(&stats->opBytes[op],0,memory_order_relaxed);
+		}
+	}
+	pthread_mutex_unlock(&internal_statsLock);
+}
+
+/**writes the profiling data of all threads to target in the given format,
+ * returns false if BigInt.c was compiled without BIG_INT_PROFILE*/
+bool bigIntWriteProfile(FILE* target,int format){
+#ifdef BIG_INT_PROFILE
+	ProfileCounters sum;
+	pthread_mutex_lock(&internal_statsLock);
+	internal_mergeProfile(&sum,&internal_retiredProfile,false);
+	for(ThreadStats* stats=internal_statsThreads;stats;stats=stats->next){
+		internal_mergeProfile(&sum,&stats->profile,true);
+	}
+	pthread_mutex_unlock(&internal_statsLock);
+	bool json=format==BIG_INT_PROFILE_JSON;
+	fputs(json?"{\"operations\":{":"operation            calls     total ns   ns/call  operand sizes (ints: calls)\n",target);
+	bool first=true;
+	for(int op=0;op<BIG_INT_OP_COUNT;op++){
+		size_t calls=atomic_load_explicit(&sum.calls[op],memory_order_relaxed);
+		if(calls==0){
+			continue;
+		}
+		size_t nanos=atomic_load_explicit(&sum.nanos[op],memory_order_relaxed);
+		if(json){
+			fprintf(target,"%s\"%s\":{\"calls\":%zu,\"ns\":%zu,\"sizes\":{",first?"":",",internal_operationNames[op],calls,nanos);
+		}else{
+			fprintf(target,"%-16s %9zu %12zu %9zu ",internal_operationNames[op],calls,nanos,nanos/calls);
+		}
+		bool firstBucket=true;
+		for(int bucket=0;bucket<BIG_INT_PROFILE_BUCKETS;bucket++){
+			size_t count=atomic_load_explicit(&sum.sizes[op][bucket],memory_order_relaxed);
+			if(count>0){
+				//lower bound of the sizes in this bucket
+				size_t size=bucket==0?0:(size_t)1<<(bucket-1);
+				fprintf(target,json?"%s\"%zu\":%zu":"%s%zu: %zu",firstBucket?"":(json?",":", "),size,count);
+				firstBucket=false;
+			}
+		}
+		fputs(json?"}}":"\n",target);
+		first=false;
+	}
+	fputs(json?"},\"branches\":{":"\nbranch                        count\n",target);
+	first=true;
+	for(int branch=0;branch<BRANCH_COUNT;branch++){
+		size_t count=atomic_load_explicit(&sum.branches[branch],memory_order_relaxed);
+		if(json){
+			fprintf(target,"%s\"%s\":%zu",first?"":",",internal_branchNames[branch],count);
+		}else if(count>0){
+			fprintf(target,"%-24s %12zu\n",internal_branchNames[branch],count);
+		}
+		first=false;
+	}
+	fputs(json?"}}\n":"",target);
+	return true;
+#else
+	(void)target;
+	(void)format;
+	return false;
+#endif
+}
+/**sets all profiling counters to zero*/
+void bigIntResetProfile(void){
+#ifdef BIG_INT_PROFILE
+	pthread_mutex_lock(&internal_statsLock);
+	internal_mergeProfile(&internal_retiredProfile,NULL,false);
+	for(ThreadStats* stats=internal_statsThreads;stats;stats=stats->next){
+		internal_mergeProfile(&stats->profile,NULL,false);
+	}
+	pthread_mutex_unlock(&internal_statsLock);
+#endif
+}
+
+//the data blocks of numbers with a capacity of 2^k ints (for BIG_INT_CACHE_MIN_CLASS<=k<=BIG_INT_CACHE_MAX_CLASS)
+//are kept in per-thread free lists when they are released and reused by later allocations of the same class
+#define BIG_INT_CACHE_MIN_CLASS 2
+#define BIG_INT_CACHE_MAX_CLASS 16
+
+typedef struct{
+	//heads of the free lists for each size class, each free block stores a pointer to the next block
+	void* blocks[BIG_INT_CACHE_MAX_CLASS+1];
+	size_t retainedBytes;
+	size_t hits;
+	size_t misses;
+	//true if the cache is registered for cleanup at thread exit
+	bool registered;
+}LimbCache;
+
+static _Thread_local LimbCache internal_limbCache;
+//maximum number of bytes kept by the cache of a single thread
+static atomic_size_t internal_limbCacheLimit=1<<22;
+static pthread_key_t internal_limbCacheKey;
+static pthread_once_t internal_limbCacheKeyOnce=PTHREAD_ONCE_INIT;
+
+static void internal_limbCacheDestructor(void* cache){
+	(void)cache;
+	bigIntReleaseThreadCache();
+}
+static void internal_createLimbCacheKey(void){
+	pthread_key_create(&internal_limbCacheKey,&internal_limbCacheDestructor);
+}
+//ensures that the cached memory of the calling thread is freed when the thread terminates
+static void internal_registerThreadCache(void){
+	if(!internal_limbCache.registered){
+		pthread_once(&internal_limbCacheKeyOnce,&internal_createLimbCacheKey);
+		pthread_setspecific(internal_limbCacheKey,&internal_limbCache);
+		internal_limbCache.registered=true;
+	}
+}
+
+//per-thread buffer for temporary data of a single function call,
+//so concurrent calls on different threads never share scratch memory
+static _Thread_local void* internal_scratchData;
+static _Thread_local size_t internal_scratchSize;
+
+//returns the scratch buffer of the calling thread with at least size bytes,
+//or NULL if the allocation failed, the buffer is only valid until the next call
+static void* internal_scratch(size_t size){
+	if(size>internal_scratchSize){
+		void* tmp=realloc(internal_scratchData,size);
+		if(!tmp){
+			return NULL;
+		}
+		if(internal_scratchData){
+			internal_countReallocation(internal_scratchSize,size);
+		}else{
+			internal_countAllocation(size);
+		}
+		internal_registerThreadCache();
+		internal_scratchData=tmp;
+		internal_scratchSize=size;
+	}
+	return internal_scratchData;
+}
+//frees the scratch buffer if it is larger than the cache limit
+static void internal_trimScratch(void){
+	if(internal_scratchSize>atomic_load_explicit(&internal_limbCacheLimit,memory_order_relaxed)){
+		internal_countFree(internal_scratchSize);
+		free(internal_scratchData);
+		internal_scratchData=NULL;
+		internal_scratchSize=0;
+	}
+}
+
+//number of bytes in the memory block of a number with the given capacity
+static size_t internal_blockBytes(size_t capacity){
+#ifdef BIG_INT_SINGLE_ALLOCATION
+	return sizeof(BigInt)+capacity*sizeof(Limb);
+#else
+	return capacity*sizeof(Limb);
+#endif
+}
+//returns the size class of capacity or -1 if blocks with this capacity are not cached
+static int internal_cacheClass(size_t capacity){
+	if(capacity<((size_t)1<<BIG_INT_CACHE_MIN_CLASS)||capacity>((size_t)1<<BIG_INT_CACHE_MAX_CLASS)
+			||(capacity&(capacity-1))!=0){
+		return -1;
+	}
+	int k=BIG_INT_CACHE_MIN_CLASS;
+	while(((size_t)1<<k)<capacity){
+		k++;
+	}
+	return k;
+}
+//rounds a requested capacity up to the capacity of its size class
+static size_t internal_roundCapacity(size_t capacity){
+	if(capacity>((size_t)1<<BIG_INT_CACHE_MAX_CLASS)){
+		return capacity;
+	}
+	size_t rounded=(size_t)1<<BIG_INT_CACHE_MIN_CLASS;
+	while(rounded<capacity){
+		rounded<<=1;
+	}
+	return rounded;
+}
+//allocates the memory block for a number with the given capacity (without counting it in the memory statistics)
+static void* internal_newBlock(BigIntContext* context,size_t capacity){
+	int k=internal_cacheClass(capacity);
+	if(context!=&internal_defaultContext||k<0){
+		return internal_allocate(context,internal_blockBytes(capacity));
+	}
+	void* block=internal_limbCache.blocks[k];
+	if(block){
+		internal_limbCache.blocks[k]=*(void**)block;
+		internal_limbCache.retainedBytes-=internal_blockBytes(capacity);
+		internal_limbCache.hits++;
+		return block;
+	}
+	internal_limbCache.misses++;
+	return malloc(internal_blockBytes(capacity));
+}
+//releases a memory block allocated with internal_newBlock (without counting it in the memory statistics)
+static void internal_dropBlock(BigIntContext* context,void* block,size_t capacity){
+	int k=internal_cacheClass(capacity);
+	size_t bytes=internal_blockBytes(capacity);
+	if(context!=&internal_defaultContext||k<0||
+			internal_limbCache.retainedBytes+bytes>atomic_load_explicit(&internal_limbCacheLimit,memory_order_relaxed)){
+		internal_release(context,block,bytes);
+		return;
+	}
+	internal_registerThreadCache();
+	*(void**)block=internal_limbCache.blocks[k];
+	internal_limbCache.blocks[k]=block;
+	internal_limbCache.retainedBytes+=bytes;
+}
+//allocates the memory block for a number with the given capacity
+static void* internal_allocBlock(BigIntContext* context,size_t capacity){
+	void* block=internal_newBlock(context,capacity);
+	if(block){
+		internal_countAllocation(internal_blockBytes(capacity));
+	}
+	return block;
+}
+//releases a memory block allocated with internal_allocBlock
+static void internal_releaseBlock(BigIntContext* context,void* block,size_t capacity){
+	internal_countFree(internal_blockBytes(capacity));
+	internal_dropBlock(context,block,capacity);
+}
+//resizes a memory block allocated with internal_allocBlock,
+//returns NULL if the allocation failed, in that case block is not modified
+static void* internal_reallocBlock(BigIntContext* context,void* block,size_t oldCapacity,size_t newCapacity){
+	size_t oldBytes=internal_blockBytes(oldCapacity),newBytes=internal_blockBytes(newCapacity);
+	void* ret;
+	if(context!=&internal_defaultContext||
+			(internal_cacheClass(oldCapacity)<0&&internal_cacheClass(newCapacity)<0)){
+		ret=internal_reallocate(context,block,oldBytes,newBytes);
+	}else{
+		ret=internal_newBlock(context,newCapacity);
+		if(ret){
+			memcpy(ret,block,oldBytes<newBytes?oldBytes:newBytes);
+			internal_dropBlock(context,block,oldCapacity);
+		}
+	}
+	if(ret){
+		internal_countReallocation(oldBytes,newBytes);
+	}
+	return ret;
+}
+
+/**sets the maximum number of bytes each thread keeps in its cache of unused memory blocks,
+ * 0 disables the cache, the limit is applied when blocks are added to a cache*/
+void bigIntSetCacheLimit(size_t maxBytes){
+	atomic_store(&internal_limbCacheLimit,maxBytes);
+}
+/**returns the statistics of the memory block cache of the calling thread*/
+BigIntCacheStats bigIntCacheStats(void){
+	return (BigIntCacheStats){
+		.hits=internal_limbCache.hits,
+		.misses=internal_limbCache.misses,
+		.retainedBytes=internal_limbCache.retainedBytes
+	};
+}
+/**frees all memory blocks and scratch buffers cached by the calling thread,
+ * this is done automatically when a thread terminates*/
+void bigIntReleaseThreadCache(void){
+	if(internal_scratchData){
+		internal_countFree(internal_scratchSize);
+	}
+	free(internal_scratchData);
+	internal_scratchData=NULL;
+	internal_scratchSize=0;
+	for(int k=BIG_INT_CACHE_MIN_CLASS;k<=BIG_INT_CACHE_MAX_CLASS;k++){
+		while(internal_limbCache.blocks[k]){
+			void* next=*(void**)internal_limbCache.blocks[k];
+			free(internal_limbCache.blocks[k]);
+			internal_limbCache.blocks[k]=next;
+		}
+	}
+	internal_limbCache.retainedBytes=0;
+}
+
+//low level kernels working on arrays of ints,
+//the arithmetic operations call them through internal_limbKernels(),
+//which selects the fastest implementation supported by the CPU on first use
+
+//target[0..n)=a+b, returns the carry, target may be equal to a or b
+static Limb internal_addPortable(Limb* target,const Limb* a,const Limb* b,size_t n){
+	DoubleLimb carry=0;
+	for(size_t i=0;i<n;i++){
+		carry+=((DoubleLimb)a[i])+b[i];
+		target[i]=carry&LIMB_MAX;
+		carry >>= INT_BITS;
+	}
+	return (Limb)carry;
+}
+//target[0..n)=a-b, returns the borrow, target may be equal to a or b
+static Limb internal_subtPortable(Limb* target,const Limb* a,const Limb* b,size_t n){
+	//the borrow is 0 or 1, it is taken from the high half of the unsigned difference
+	DoubleLimb borrow=0;
+	for(size_t i=0;i<n;i++){
+		DoubleLimb diff=((DoubleLimb)a[i])-b[i]-borrow;
+		target[i]=diff&LIMB_MAX;
+		borrow=(diff>>INT_BITS)&1;
+	}
+	return (Limb)borrow;
+}
+//target[0..n)=a*b, returns the high int of the product, target must not overlap a
+static Limb internal_mul1Portable(Limb* target,const Limb* a,size_t n,Limb b){
+	DoubleLimb carry=0;
+	for(size_t i=0;i<n;i++){
+		carry+=((DoubleLimb)a[i])*b;
+		target[i]=carry&LIMB_MAX;
+		carry >>= INT_BITS;
+	}
+	return (Limb)carry;
+}
+//target[0..n)+=a*b, returns the carry, target must not overlap a
+static Limb internal_addMul1Portable(Limb* target,const Limb* a,size_t n,Limb b){
+	DoubleLimb carry=0;
+	for(size_t i=0;i<n;i++){
+		carry+=((DoubleLimb)a[i])*b+target[i];
+		target[i]=carry&LIMB_MAX;
+		carry >>= INT_BITS;
+	}
+	return (Limb)carry;
+}
+//target[0..n)-=a*b, returns the borrow, target must not overlap a
+static Limb internal_subMul1Portable(Limb* target,const Limb* a,size_t n,Limb b){
+	Limb borrow=0;
+	for(size_t i=0;i<n;i++){
+		DoubleLimb prod=((DoubleLimb)a[i])*b+borrow;
+		Limb low=prod&LIMB_MAX;
+		borrow=(prod>>INT_BITS)+(target[i]<low);
+		target[i]-=low;
+	}
+	return borrow;
+}
+
+#ifdef BIG_INT_X86_KERNELS
+//x86-64 versions of the kernels, the loops are controlled with lea and jrcxz,
+//which do not modify the carry (CF) and overflow (OF) flags used by the carry chains
+static Limb internal_addX86(Limb* target,const Limb* a,const Limb* b,size_t n){
+	Limb carry=0;
+	size_t i=0,rem=n&3,blocks=n>>2;
+	__asm__ volatile(
+		"clc\n\t"
+		"jrcxz 2f\n"
+		"1:\n\t"
+		"movq (%[a],%[i],8), %%rax\n\t"
+		"adcq (%[b],%[i],8), %%rax\n\t"
+		"movq %%rax, (%[t],%[i],8)\n\t"
+		"leaq 1(%[i]), %[i]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n"
+		"2:\n\t"
+		"movq %[blocks], %%rcx\n\t"
+		"jrcxz 4f\n"
+		"3:\n\t"
+		"movq (%[a],%[i],8), %%rax\n\t"
+		"movq 8(%[a],%[i],8), %%rdx\n\t"
+		"movq 16(%[a],%[i],8), %%r8\n\t"
+		"movq 24(%[a],%[i],8), %%r9\n\t"
+		"adcq (%[b],%[i],8), %%rax\n\t"
+		"adcq 8(%[b],%[i],8), %%rdx\n\t"
+		"adcq 16(%[b],%[i],8), %%r8\n\t"
+		"adcq 24(%[b],%[i],8), %%r9\n\t"
+		"movq %%rax, (%[t],%[i],8)\n\t"
+		"movq %%rdx, 8(%[t],%[i],8)\n\t"
+		"movq %%r8, 16(%[t],%[i],8)\n\t"
+		"movq %%r9, 24(%[t],%[i],8)\n\t"
+		"leaq 4(%[i]), %[i]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 4f\n\t"
+		"jmp 3b\n"
+		"4:\n\t"
+		"adcq $0, %[carry]\n"
+		:[carry]"+r"(carry),[i]"+r"(i),"+c"(rem)
+		:[a]"r"(a),[b]"r"(b),[t]"r"(target),[blocks]"r"(blocks)
+		:"rax","rdx","r8","r9","cc","memory");
+	return carry;
+}
+static Limb internal_subtX86(Limb* target,const Limb* a,const Limb* b,size_t n){
+	Limb borrow=0;
+	size_t i=0,rem=n&3,blocks=n>>2;
+	__asm__ volatile(
+		"clc\n\t"
+		"jrcxz 2f\n"
+		"1:\n\t"
+		"movq (%[a],%[i],8), %%rax\n\t"
+		"sbbq (%[b],%[i],8), %%rax\n\t"
+		"movq %%rax, (%[t],%[i],8)\n\t"
+		"leaq 1(%[i]), %[i]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n"
+		"2:\n\t"
+		"movq %[blocks], %%rcx\n\t"
+		"jrcxz 4f\n"
+		"3:\n\t"
+		"movq (%[a],%[i],8), %%rax\n\t"
+		"movq 8(%[a],%[i],8), %%rdx\n\t"
+		"movq 16(%[a],%[i],8), %%r8\n\t"
+		"movq 24(%[a],%[i],8), %%r9\n\t"
+		"sbbq (%[b],%[i],8), %%rax\n\t"
+		"sbbq 8(%[b],%[i],8), %%rdx\n\t"
+		"sbbq 16(%[b],%[i],8), %%r8\n\t"
+		"sbbq 24(%[b],%[i],8), %%r9\n\t"
+		"movq %%rax, (%[t],%[i],8)\n\t"
+		"movq %%rdx, 8(%[t],%[i],8)\n\t"
+		"movq %%r8, 16(%[t],%[i],8)\n\t"
+		"movq %%r9, 24(%[t],%[i],8)\n\t"
+		"leaq 4(%[i]), %[i]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 4f\n\t"
+		"jmp 3b\n"
+		"4:\n\t"
+		"adcq $0, %[borrow]\n"
+		:[borrow]"+r"(borrow),[i]"+r"(i),"+c"(rem)
+		:[a]"r"(a),[b]"r"(b),[t]"r"(target),[blocks]"r"(blocks)
+		:"rax","rdx","r8","r9","cc","memory");
+	return borrow;
+}
+//mulx (BMI2) computes the products without modifying the flags,
+//the high half of each product is added to the next low half with adcx (CF chain)
+static Limb internal_mul1X86(Limb* target,const Limb* a,size_t n,Limb b){
+	Limb carry=0;
+	size_t i=0;
+	if(n==0){
+		return 0;
+	}
+	__asm__ volatile(
+		"xorl %%eax, %%eax\n"
+		"1:\n\t"
+		"mulxq (%[a],%[i],8), %%r8, %%r9\n\t"
+		"adcxq %[carry], %%r8\n\t"
+		"movq %%r8, (%[t],%[i],8)\n\t"
+		"movq %%r9, %[carry]\n\t"
+		"leaq 1(%[i]), %[i]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n"
+		"2:\n\t"
+		"adcxq %%rax, %[carry]\n"
+		:[carry]"+r"(carry),[i]"+r"(i),"+c"(n)
+		:[a]"r"(a),[t]"r"(target),"d"(b)
+		:"rax","r8","r9","cc","memory");
+	return carry;
+}
+//like internal_mul1X86, with a second carry chain (adox, OF chain) that adds the products to target,
+//the loop handles two ints per iteration
+static Limb internal_addMul1X86(Limb* target,const Limb* a,size_t n,Limb b){
+	Limb carry=0;
+	size_t i=0,pairs=n>>1;
+	if(n&1){
+		carry=internal_addMul1Portable(target,a,1,b);
+		i=1;
+	}
+	if(pairs==0){
+		return carry;
+	}
+	__asm__ volatile(
+		"xorl %%eax, %%eax\n"
+		"1:\n\t"
+		"mulxq (%[a],%[i],8), %%r8, %%r9\n\t"
+		"adcxq %[carry], %%r8\n\t"
+		"adoxq (%[t],%[i],8), %%r8\n\t"
+		"movq %%r8, (%[t],%[i],8)\n\t"
+		"mulxq 8(%[a],%[i],8), %%r10, %[carry]\n\t"
+		"adcxq %%r9, %%r10\n\t"
+		"adoxq 8(%[t],%[i],8), %%r10\n\t"
+		"movq %%r10, 8(%[t],%[i],8)\n\t"
+		"leaq 2(%[i]), %[i]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n"
+		"2:\n\t"
+		"adcxq %%rax, %[carry]\n\t"
+		"adoxq %%rax, %[carry]\n"
+		:[carry]"+r"(carry),[i]"+r"(i),"+c"(pairs)
+		:[a]"r"(a),[t]"r"(target),"d"(b)
+		:"rax","r8","r9","r10","cc","memory");
+	return carry;
+}
+//like internal_addMul1X86, there is no subtraction on the OF chain, so the products are added
+//to the complement of target (~(~t+p)==t-p), the carry out of ~t+p is the borrow of t-p
+static Limb internal_subMul1X86(Limb* target,const Limb* a,size_t n,Limb b){
+	Limb borrow=0;
+	size_t i=0,pairs=n>>1;
+	if(n&1){
+		borrow=internal_subMul1Portable(target,a,1,b);
+		i=1;
+	}
+	if(pairs==0){
+		return borrow;
+	}
+	__asm__ volatile(
+		"xorl %%eax, %%eax\n"
+		"1:\n\t"
+		"mulxq (%[a],%[i],8), %%r8, %%r9\n\t"
+		"adcxq %[borrow], %%r8\n\t"
+		"movq (%[t],%[i],8), %%r11\n\t"
+		"notq %%r11\n\t"
+		"adoxq %%r8, %%r11\n\t"
+		"notq %%r11\n\t"
+		"movq %%r11, (%[t],%[i],8)\n\t"
+		"mulxq 8(%[a],%[i],8), %%r10, %[borrow]\n\t"
+		"adcxq %%r9, %%r10\n\t"
+		"movq 8(%[t],%[i],8), %%r11\n\t"
+		"notq %%r11\n\t"
+		"adoxq %%r10, %%r11\n\t"
+		"notq %%r11\n\t"
+		"movq %%r11, 8(%[t],%[i],8)\n\t"
+		"leaq 2(%[i]), %[i]\n\t"
+		"leaq -1(%%rcx), %%rcx\n\t"
+		"jrcxz 2f\n\t"
+		"jmp 1b\n"
+		"2:\n\t"
+		"adcxq %%rax, %[borrow]\n\t"
+		"adoxq %%rax, %[borrow]\n"
+		:[borrow]"+r"(borrow),[i]"+r"(i),"+c"(pairs)
+		:[a]"r"(a),[t]"r"(target),"d"(b)
+		:"rax","r8","r9","r10","r11","cc","memory");
+	return borrow;
+}
+#endif
+
+typedef struct{
+	const char* name;
+	Limb (*add)(Limb* target,const Limb* a,const Limb* b,size_t n);
+	Limb (*subt)(Limb* target,const Limb* a,const Limb* b,size_t n);
+	Limb (*mul1)(Limb* target,const Limb* a,size_t n,Limb b);
+	Limb (*addMul1)(Limb* target,const Limb* a,size_t n,Limb b);
+	Limb (*subMul1)(Limb* target,const Limb* a,size_t n,Limb b);
+}LimbKernels;
+
+static const LimbKernels internal_portableKernels={
+	.name="portable",
+	.add=&internal_addPortable,
+	.subt=&internal_subtPortable,
+	.mul1=&internal_mul1Portable,
+	.addMul1=&internal_addMul1Portable,
+	.subMul1=&internal_subMul1Portable
+};
+#ifdef BIG_INT_X86_KERNELS
+static const LimbKernels internal_x86Kernels={
+	.name="adx",
+	.add=&internal_addX86,
+	.subt=&internal_subtX86,
+	.mul1=&internal_mul1X86,
+	.addMul1=&internal_addMul1X86,
+	.subMul1=&internal_subMul1X86
+};
+#endif
+
+//fastest kernels supported by the CPU
+static const LimbKernels* internal_detectKernels(void){
+#ifdef BIG_INT_X86_KERNELS
+	unsigned int eax,ebx,ecx,edx;
+	if(__get_cpuid_count(7,0,&eax,&ebx,&ecx,&edx)&&(ebx&bit_BMI2)&&(ebx&bit_ADX)){
+		return &internal_x86Kernels;
+	}
+#endif
+	return &internal_portableKernels;
+}
+
+static _Atomic(const LimbKernels*) internal_kernels=NULL;
+static inline const LimbKernels* internal_limbKernels(void){
+	const LimbKernels* kernels=atomic_load_explicit(&internal_kernels,memory_order_relaxed);
+	if(kernels==NULL){
+		//detecting the kernels twice is harmless, so concurrent first calls don't need to synchronize
+		kernels=internal_detectKernels();
+		atomic_store_explicit(&internal_kernels,kernels,memory_order_relaxed);
+	}
+	return kernels;
+}
+
+/**selects the implementation of the arithmetic kernels by name,
+ * NULL selects the fastest implementation supported by the CPU,
+ * returns false if the implementation is not available (the selection is not changed in that case)*/
+bool bigIntSetKernels(const char* name){
+	const LimbKernels* kernels=NULL;
+	if(name==NULL){
+		kernels=internal_detectKernels();
+	}else if(strcmp(name,internal_portableKernels.name)==0){
+		kernels=&internal_portableKernels;
+#ifdef BIG_INT_X86_KERNELS
+	}else if(strcmp(name,internal_x86Kernels.name)==0&&internal_detectKernels()==&internal_x86Kernels){
+		kernels=&internal_x86Kernels;
+#endif
+	}
+	if(kernels){
+		atomic_store_explicit(&internal_kernels,kernels,memory_order_relaxed);
+	}
+	return kernels!=NULL;
+}
+/**name of the kernels used by the arithmetic operations*/
+const char* bigIntKernels(void){
+	return internal_limbKernels()->name;
+}
+
+//primitives on spans of ints (least significant int first),
+//the arithmetic operations of the BigInt API are built on top of them,
+//spans are not standardized (they may have leading zeros) and never reallocated
+
+//target[0..n)=a+b, returns the carry, target may be equal to a or b
+static inline Limb internal_addN(Limb* target,const Limb* a,const Limb* b,size_t n){
+	return internal_limbKernels()->add(target,a,b,n);
+}
+//target[0..n)=a-b, returns the borrow, target may be equal to a or b
+static inline Limb internal_subN(Limb* target,const Limb* a,const Limb* b,size_t n){
+	return internal_limbKernels()->subt(target,a,b,n);
+}
+//target[0..n)=a*b, returns the high int of the product, target must not overlap a
+static inline Limb internal_mul1(Limb* target,const Limb* a,size_t n,Limb b){
+	return internal_limbKernels()->mul1(target,a,n,b);
+}
+//target[0..n)+=a*b, returns the carry, target must not overlap a
+static inline Limb internal_addMul1(Limb* target,const Limb* a,size_t n,Limb b){
+	return internal_limbKernels()->addMul1(target,a,n,b);
+}
+//target[0..n)-=a*b, returns the borrow, target must not overlap a
+static inline Limb internal_subMul1(Limb* target,const Limb* a,size_t n,Limb b){
+	return internal_limbKernels()->subMul1(target,a,n,b);
+}
+//target[0..n)=a (a and target may overlap)
+static inline void internal_copy(Limb* target,const Limb* a,size_t n){
+	if(n>0&&target!=a){
+		memmove(target,a,n*sizeof(Limb));
+	}
+}
+//target[0..n)=a+value, returns the carry, target may be equal to a
+static Limb internal_add1(Limb* target,const Limb* a,size_t n,Limb value){
+	size_t i=0;
+	for(;i<n&&value!=0;i++){
+		Limb sum=a[i]+value;
+		value=sum<value;
+		target[i]=sum;
+	}
+	internal_copy(target+i,a+i,n-i);
+	return value;
+}
+//target[0..n)=a-value, returns the borrow, target may be equal to a
+static Limb internal_sub1(Limb* target,const Limb* a,size_t n,Limb value){
+	size_t i=0;
+	for(;i<n&&value!=0;i++){
+		Limb diff=a[i]-value;
+		value=a[i]<value;
+		target[i]=diff;
+	}
+	internal_copy(target+i,a+i,n-i);
+	return value;
+}
+//target[0..an)=a+b for an>=bn, returns the carry, target may be equal to a or b
+static Limb internal_add(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	Limb carry=internal_addN(target,a,b,bn);
+	return internal_add1(target+bn,a+bn,an-bn,carry);
+}
+//target[0..an)=a-b for an>=bn, returns the borrow, target may be equal to a or b
+static Limb internal_sub(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	Limb borrow=internal_subN(target,a,b,bn);
+	return internal_sub1(target+bn,a+bn,an-bn,borrow);
+}
+//target[0..n)=a<<bits for 0<bits<INT_BITS, returns the bits shifted out of the highest int,
+//the ints are processed from the highest to the lowest, so target may be equal to or above a
+static Limb internal_lshift(Limb* target,const Limb* a,size_t n,unsigned int bits){
+	Limb out=a[n-1]>>(INT_BITS-bits);
+	for(size_t i=n-1;i>0;i--){
+		target[i]=(a[i]<<bits)|(a[i-1]>>(INT_BITS-bits));
+	}
+	target[0]=a[0]<<bits;
+	return out;
+}
+//target[0..n)=a>>bits for 0<bits<INT_BITS, returns the bits shifted out of the lowest int (in the high bits),
+//the ints are processed from the lowest to the highest, so target may be equal to or below a
+static Limb internal_rshift(Limb* target,const Limb* a,size_t n,unsigned int bits){
+	Limb out=a[0]<<(INT_BITS-bits);
+	for(size_t i=0;i+1<n;i++){
+		target[i]=(a[i]>>bits)|(a[i+1]<<(INT_BITS-bits));
+	}
+	target[n-1]=a[n-1]>>bits;
+	return out;
+}
+//compares a[0..n) and b[0..n), returns -1, 0 or 1
+static int internal_cmpN(const Limb* a,const Limb* b,size_t n){
+	for(size_t i=n;i>0;i--){
+		if(a[i-1]!=b[i-1]){
+			return a[i-1]<b[i-1]?-1:1;
+		}
+	}
+	return 0;
+}
+//number of ints in a[0..n) without leading zeros
+static inline size_t internal_normSize(const Limb* a,size_t n){
+	while(n>0&&a[n-1]==0){
+		n--;
+	}
+	return n;
+}
+//compares a[0..an) and b[0..bn) (leading zeros are ignored), returns -1, 0 or 1
+static int internal_cmp(const Limb* a,size_t an,const Limb* b,size_t bn){
+	an=internal_normSize(a,an);
+	bn=internal_normSize(b,bn);
+	if(an!=bn){
+		return an<bn?-1:1;
+	}
+	return internal_cmpN(a,b,an);
+}
+//target[0..n)=|a-b| for a[0..n) and b[0..bn) with bn<=n, returns true if a<b, target may be equal to a or b
+static bool internal_absDiff(Limb* target,const Limb* a,size_t n,const Limb* b,size_t bn){
+	if(internal_cmp(a,n,b,bn)<0){
+		internal_sub(target,b,bn,a,internal_normSize(a,n));
+		memset(target+bn,0,(n-bn)*sizeof(Limb));
+		return true;
+	}
+	internal_sub(target,a,n,b,bn);
+	return false;
+}
+//target[0..n)=a/d for an odd number d that divides a, target may be equal to a
+static void internal_divExact1(Limb* target,const Limb* a,size_t n,Limb d){
+	//inverse of d modulo 2^INT_BITS, each Newton step doubles the number of correct bits
+	Limb inverse=d;
+	for(int bits=3;bits<INT_BITS;bits*=2){
+		inverse*=2-d*inverse;
+	}
+	Limb borrow=0;
+	for(size_t i=0;i<n;i++){
+		Limb x=a[i];
+		Limb q=(x-borrow)*inverse;
+		target[i]=q;
+		borrow=(x<borrow)+(Limb)((((DoubleLimb)q)*d)>>INT_BITS);
+	}
+	assert(borrow==0);
+}
+//target[0..an+bn)=a*b for an>=1, bn>=1,
+//target must not overlap b, it may be equal to a (the rows are processed from the highest int of a downwards,
+//row i only overwrites a[i] after reading it)
+static void internal_mulBasecase(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	size_t i=an-1;
+	Limb factor=a[i];
+	target[i+bn]=internal_mul1(target+i,b,bn,factor);
+	while(i-->0){
+		factor=a[i];
+		target[i]=0;
+		Limb carry=internal_addMul1(target+i,b,bn,factor);
+		internal_add1(target+i+bn,target+i+bn,an-i,carry);
+	}
+}
+//number of scratch ints needed by internal_karatsubaMulN (internal_karatsubaSqrN) if the larger factor has n ints
+//and the recursion stops at threshold ints, the scratch is bounded by 2n+2*log2(n) ints
+static size_t internal_karatsubaScratch(size_t n,size_t threshold){
+	size_t total=0;
+	while(n>threshold){
+		n-=n/2;
+		total+=2*n;
+	}
+	return total;
+}
+//target[0..an+bn)=a*b with the Karatsuba multiplication algorithm, target must not overlap a or b,
+//scratch has to contain at least internal_karatsubaScratch(max(an,bn),KARATSUBA_THRESHOLD) ints,
+//the partial products are written directly into target, no memory is allocated
+static void internal_karatsubaMulN(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn,Limb* scratch){
+	if(an<bn){
+		const Limb* tmp=a;
+		a=b;
+		b=tmp;
+		size_t tmpN=an;
+		an=bn;
+		bn=tmpN;
+	}
+	if(bn<=KARATSUBA_THRESHOLD){
+		internal_mulBasecase(target,a,an,b,bn);
+		return;
+	}
+	size_t half=an-an/2,highN=an-half;//a=aH*B^half+aL, aL has half ints, aH has highN<=half ints
+	if(bn<=half){
+		//b is too small to be split: a*b=aH*b*B^half+aL*b
+		internal_karatsubaMulN(target,a,half,b,bn,scratch+2*half);
+		internal_karatsubaMulN(scratch,a+half,highN,b,bn,scratch+2*half);
+		memset(target+half+bn,0,highN*sizeof(Limb));
+		Limb carry=internal_add(target+half,target+half,highN+bn,scratch,highN+bn);
+		assert(carry==0);
+		(void)carry;
+		return;
+	}
+	size_t bHighN=bn-half;
+	//|aL-aH| and |bL-bH| are stored in the low half of target, which is overwritten by aL*bL later
+	Limb* diffA=target;
+	Limb* diffB=target+half;
+	bool negA=internal_absDiff(diffA,a,half,a+half,highN);
+	bool negB=internal_absDiff(diffB,b,half,b+half,bHighN);
+	//mid=(aL-aH)(bL-bH) in the first 2*half ints of scratch
+	Limb* mid=scratch;
+	internal_karatsubaMulN(mid,diffA,half,diffB,half,scratch+2*half);
+	internal_karatsubaMulN(target,a,half,b,half,scratch+2*half);
+	internal_karatsubaMulN(target+2*half,a+half,highN,b+half,bHighN,scratch+2*half);
+	//aL*bH+aH*bL=aL*bL+aH*bH-(aL-aH)(bL-bH)
+	Limb top;
+	if(negA==negB){
+		Limb borrow=internal_subN(mid,target,mid,2*half);
+		top=internal_add(mid,mid,2*half,target+2*half,highN+bHighN)-borrow;
+	}else{
+		top=internal_addN(mid,mid,target,2*half);
+		top+=internal_add(mid,mid,2*half,target+2*half,highN+bHighN);
+	}
+	size_t n=an+bn;
+	Limb carry=internal_add(target+half,target+half,n-half,mid,2*half);
+	carry+=internal_add1(target+3*half,target+3*half,n-3*half,top);
+	assert(carry==0);
+	(void)carry;
+}
+//target[0..2n)=a*a for n>=1, target must not overlap a,
+//each product a[i]*a[j] with i!=j is computed once and doubled afterwards
+static void internal_sqrBasecase(Limb* target,const Limb* a,size_t n){
+	target[0]=0;
+	target[2*n-1]=0;
+	if(n>1){
+		//products below the diagonal
+		target[n]=internal_mul1(target+1,a+1,n-1,a[0]);
+		for(size_t i=1;i+1<n;i++){
+			target[n+i]=internal_addMul1(target+2*i+1,a+i+1,n-i-1,a[i]);
+		}
+		Limb out=internal_lshift(target,target,2*n,1);
+		assert(out==0);
+		(void)out;
+	}
+	//add the squares on the diagonal
+	Limb carry=0;
+	for(size_t i=0;i<n;i++){
+		DoubleLimb square=((DoubleLimb)a[i])*a[i];
+		DoubleLimb sum=(DoubleLimb)target[2*i]+(square&LIMB_MAX)+carry;
+		target[2*i]=sum&LIMB_MAX;
+		sum=(DoubleLimb)target[2*i+1]+(square>>INT_BITS)+(sum>>INT_BITS);
+		target[2*i+1]=sum&LIMB_MAX;
+		carry=sum>>INT_BITS;
+	}
+	assert(carry==0);
+}
+//target[0..2n)=a*a with the Karatsuba algorithm (three squares of half the size),
+//target must not overlap a, scratch has to contain at least internal_karatsubaScratch(n,KARATSUBA_SQR_THRESHOLD) ints
+static void internal_karatsubaSqrN(Limb* target,const Limb* a,size_t n,Limb* scratch){
+	if(n<=KARATSUBA_SQR_THRESHOLD){
+		internal_sqrBasecase(target,a,n);
+		return;
+	}
+	size_t half=n-n/2,highN=n-half;
+	//|aL-aH| is stored in the low half of target, which is overwritten by aL*aL later
+	Limb* diff=target;
+	internal_absDiff(diff,a,half,a+half,highN);
+	Limb* mid=scratch;
+	internal_karatsubaSqrN(mid,diff,half,scratch+2*half);
+	internal_karatsubaSqrN(target,a,half,scratch+2*half);
+	internal_karatsubaSqrN(target+2*half,a+half,highN,scratch+2*half);
+	//2*aL*aH=aL*aL+aH*aH-(aL-aH)^2
+	Limb borrow=internal_subN(mid,target,mid,2*half);
+	Limb top=internal_add(mid,mid,2*half,target+2*half,2*highN)-borrow;
+	Limb carry=internal_add(target+half,target+half,2*n-half,mid,2*half);
+	carry+=internal_add1(target+3*half,target+3*half,2*n-3*half,top);
+	assert(carry==0);
+	(void)carry;
+}
+//number of leading zero bits of value!=0
+static int internal_leadingZeros(Limb value){
+	int zeros=0;
+	for(Limb top=((Limb)1)<<(INT_BITS-1);(value&top)==0;top>>=1){
+		zeros++;
+	}
+	return zeros;
+}
+//schoolbook division (Knuth's algorithm D) of a[0..an] by b[0..bn) for an>=bn>=2,
+//b has to be normalized (highest bit of b[bn-1] set) and a[an]<=b[bn-1],
+//the quotient (an-bn+1 ints) is written to q (if q is not NULL), the remainder replaces a[0..bn)
+static void internal_divRemBasecase(Limb* q,Limb* a,size_t an,const Limb* b,size_t bn){
+	Limb top=b[bn-1],second=b[bn-2];
+	for(size_t j=an-bn+1;j-->0;){
+		//estimate the quotient digit from the highest two ints of the remainder
+		DoubleLimb num=(((DoubleLimb)a[j+bn])<<INT_BITS)|a[j+bn-1];
+		DoubleLimb qHat=num/top,rHat=num%top;
+		while(qHat>LIMB_MAX||qHat*second>((rHat<<INT_BITS)|a[j+bn-2])){
+			qHat--;
+			rHat+=top;
+			if(rHat>LIMB_MAX){
+				break;
+			}
+		}
+		Limb borrow=internal_subMul1(a+j,b,bn,(Limb)qHat);
+		if(a[j+bn]<borrow){//qHat was one too large
+			qHat--;
+			a[j+bn]+=internal_addN(a+j,a+j,b,bn);
+		}
+		a[j+bn]-=borrow;
+		if(q){
+			q[j]=(Limb)qHat;
+		}
+	}
+}
+
 static BigInt BIG_VAL_ZERO;
 static BigInt BIG_VAL_ONE;
-BigInt* BIG_INT_ZERO=&BIG_VAL_ZERO;
-BigInt* BIG_INT_ONE=&BIG_VAL_ONE;
+BigInt* const BIG_INT_ZERO=&BIG_VAL_ZERO;
+BigInt* const BIG_INT_ONE=&BIG_VAL_ONE;
 static BigInt BIG_VAL_ZERO=(BigInt){
+		.context=&internal_defaultContext,
 		.sgn=0,
 		.size=0,
+		.capacity=0,
 		.data=NULL
 };
 static BigInt BIG_VAL_ONE=(BigInt){
+		.context=&internal_defaultContext,
 		.sgn=0,
 		.size=1,
-		.data=(uint32_t[]){1}
+		.capacity=1,
+		.data=(Limb[]){1}
 };
+//the constants are shared by all threads, consuming them is ignored so they are never modified or freed
+static inline bool internal_canConsume(BigInt* a){
+	return a!=BIG_INT_ZERO&&a!=BIG_INT_ONE;
+}
 
 
-//creates a BigInt from a 64bit int value
-BigInt* createBigIntInt(int64_t value){
-	BigInt* create=malloc(sizeof(BigInt));
-	if(create!=NULL){
-		if(value==0){
-			create->size=0;
-			create->sgn=0;
-			create->data=NULL;
-			return create;
+//returns uninitialized BigInt with the given size
+static BigInt* createBigIntSize(size_t size){
+	BigIntContext* context=internal_currentContext;
+#ifdef BIG_INT_SINGLE_ALLOCATION
+	size_t capacity=internal_roundCapacity(size);
+	BigInt* ret=internal_allocBlock(context,capacity);
+	if(ret){
+		ret->context=context;
+		ret->size=size;
+		ret->sgn=0;
+		ret->data=ret->inlineData;
+		ret->capacity=capacity;
+	}
+	return ret;
+#else
+	BigInt* ret=internal_allocate(context,sizeof(BigInt));
+	if(ret){
+		internal_countAllocation(sizeof(BigInt));
+		ret->context=context;
+		ret->size=size;
+		ret->sgn=0;
+		if(size<=BIG_INT_INLINE_SIZE){
+			ret->data=ret->inlineData;
+			ret->capacity=BIG_INT_INLINE_SIZE;
 		}else{
-			if(value<0){
-				create->sgn=UINT32_MAX;
-				value=-value;
-			}else{
-				create->sgn=0;
-			}
-			if(value&0xffffffff00000000ULL){
-				create->size=2;
-				create->data=malloc(2*sizeof(int32_t));
-				if(create->data){
-					create->data[0]=value&UINT32_MAX;
-					create->data[1] = (value >> INT_BITS) & UINT32_MAX;
-				}else{
-					freeBigInt(create);
-					return NULL;
-				}
-			}else{
-				create->size=1;
-				create->data=malloc(sizeof(int32_t));
-				if(create->data){
-					create->data[0]=value&0xffffffff;
-				}else{
-					freeBigInt(create);
-					return NULL;
-				}
+			ret->capacity=internal_roundCapacity(size);
+			ret->data=internal_allocBlock(context,ret->capacity);
+			if(ret->data==NULL){
+				internal_countFree(sizeof(BigInt));
+				internal_release(context,ret,sizeof(BigInt));
+				return NULL;
 			}
 		}
 	}
+	return ret;
+#endif
+}
+
+//creates a BigInt from a 64bit int value
+BigInt* createBigIntInt(int64_t value){
+	BigInt* create=createBigIntSize(0);
+	if(create!=NULL&&value!=0){
+		if(value<0){
+			create->sgn=LIMB_MAX;
+		}
+		//the absolute value is computed unsigned, so INT64_MIN does not overflow
+		uint64_t absValue=value<0?-(uint64_t)value:(uint64_t)value;
+#ifdef BIG_INT_64BIT_LIMBS
+		create->data[0]=absValue;
+		create->size=1;
+#else
+		create->data[0]=absValue&LIMB_MAX;
+		create->data[1]=(absValue >> INT_BITS) & LIMB_MAX;
+		create->size=create->data[1]!=0?2:1;
+#endif
+	}
 	return create;
 }
 static uint32_t internal_digitFromChar(char c,bool bigBase){
@@ -100,85 +1726,77 @@ static uint32_t internal_digitFromChar(char c,bool bigBase){
 		return UINT32_MAX;
 	}
 }
-/*creates a BigInt from a null-terminated string
- *base should be between 2 and 62*///addLater describe case handling
-BigInt* createBigIntCStr(const char* str,int base){
-	return createBigIntStr(str,strlen(str),base);
+static BigInt* internal_standardizeBigInt(BigInt* number);
+
+//creates a non-negative BigInt from a value that fits into two ints
+static BigInt* internal_createBigIntDoubleLimb(DoubleLimb value){
+	BigInt* create=createBigIntSize(2);
+	if(create){
+		create->data[0]=value&LIMB_MAX;
+		create->data[1]=value>>INT_BITS;
+		create=internal_standardizeBigInt(create);
+	}
+	return create;
 }
-/*creates a BigInt from a string
- *base should be between 2 and 62*///addLater describe case handling
-BigInt* createBigIntStr(const char* stringValue,size_t stringLen,int base){
-	if(base<2||base>BIGINT_MAX_BASE){
-		return NULL;
+
+/**creates a BigInt from the given array of integers,
+ * value is directly used as data-block of the new BigInt
+ * (or copied if the data cannot be adopted by the current context)*/
+BigInt* createBigIntInts(uint32_t sgn,uint32_t* value,size_t size){
+	if(value==NULL){
+		return createBigIntSize(0);
 	}
-	BigInt* ret=createBigIntInt(0);//addLater shortcut-method for pow2 bases
-	BigInt* bigIntBase=createBigIntInt(base);
-	bool bigBase=base>36;
-	for(size_t i=0;i<stringLen;i++){//addLater? more efficient algorithm
-		ret=multBigInt(ret,true,bigIntBase,false);
-		if(!ret){
-			break;
-		}
-		uint32_t digit=internal_digitFromChar(stringValue[i],bigBase);
-		if(digit<base){
-			ret=addBigInt(ret,true,createBigIntInt(digit),true);
-			if(!ret){
-				break;
+#ifdef BIG_INT_64BIT_LIMBS
+	//pairs of 32bit ints are combined into a single 64bit int
+	BigInt* create=createBigIntSize((size+1)/2);
+	if(create){
+		create->sgn=sgn?LIMB_MAX:0;
+		for(size_t i=0;i<size;i++){
+			if(i%2==0){
+				create->data[i/2]=value[i];
+			}else{
+				create->data[i/2]|=((Limb)value[i])<<32;
 			}
-		}else{
-			freeBigInt(ret);
-			freeBigInt(bigIntBase);
-			return NULL;
 		}
+		create=internal_standardizeBigInt(create);
 	}
-	freeBigInt(bigIntBase);
-	return ret;
-}
-/**creates a BigInt from the given array of integers*/
-BigInt* createBigIntBytes(void* bytes,size_t numBytes){
-	return NULL;//TODO createBigIntBytes
-}
-/**creates a BigInt from the given array of integers*/
-BigInt* createBigIntInts(uint32_t sgn,uint32_t* value,size_t size){
-	BigInt* create=malloc(sizeof(BigInt));
+	free(value);
+	return create;
+#else
+#ifndef BIG_INT_SINGLE_ALLOCATION
+	if(internal_currentContext==&internal_defaultContext){
+		BigInt* create=malloc(sizeof(BigInt));
+		if(create){
+			//the adopted data block is released (and counted) like the blocks allocated by this library
+			internal_countAllocation(sizeof(BigInt));
+			internal_countAllocation(size*sizeof(Limb));
+			create->context=&internal_defaultContext;
+			create->sgn=sgn;
+			create->data=value;
+			create->size=size;
+			create->capacity=size;
+		}
+		return create;
+	}
+#endif
+	BigInt* create=createBigIntSize(size);
 	if(create){
 		create->sgn=sgn;
-		create->data=value;
-		create->size=value==NULL?0:size;
+		memcpy(create->data,value,size*sizeof(Limb));
+		free(value);
 	}
 	return create;
-}
-//returns uninitialized BigInt with the given size
-static BigInt* createBigIntSize(size_t size){
-	   uint32_t* newData=malloc(size*sizeof(uint32_t));
-	   if(newData){
-		   BigInt* ret=malloc(sizeof(BigInt));
-		   if(ret){
-			   ret->size=size;
-			   ret->sgn=0;
-			   ret->data=newData;
-		   }else{
-			   free(newData);
-			   return NULL;
-		   }
-		   return ret;
-	   }
-	return NULL;
+#endif
 }
 
 /**creates a clone of the given BigInteger*/
 BigInt* cloneBigInt(BigInt* source){
 	if(source){
-		BigInt* clone=malloc(sizeof(BigInt));
+		BigInt* clone=createBigIntSize(source->size);
 		if(clone){
-			clone->size=source->size;
 			clone->sgn=source->sgn;
-			clone->data=malloc(source->size*sizeof(uint32_t));
-			if(clone->data){
-				memcpy(clone->data,source->data,source->size*sizeof(uint32_t));
-			}else{
-				freeBigInt(clone);
-				return NULL;
+			if(source->size>0){
+				memcpy(clone->data,source->data,source->size*sizeof(Limb));
 			}
 		}
 		return clone;
@@ -188,45 +1806,171 @@ BigInt* cloneBigInt(BigInt* source){
 
 /**frees the given BigInteger*/
 void freeBigInt(BigInt* toFree){
-	if(toFree){
-		free(toFree->data);
+	if(toFree&&internal_canConsume(toFree)){
+#ifdef BIG_INT_SINGLE_ALLOCATION
+		internal_releaseBlock(toFree->context,toFree,toFree->capacity);
+#else
+		if(toFree->data!=toFree->inlineData){
+			internal_releaseBlock(toFree->context,toFree->data,toFree->capacity);
+		}
 		toFree->data=NULL;
-		free(toFree);
+		internal_countFree(sizeof(BigInt));
+		internal_release(toFree->context,toFree,sizeof(BigInt));
+#endif
+	}
+}
+
+//ensures that number can hold at least capacity ints without further reallocation,
+//the capacity is grown geometrically to keep the cost of repeated growth amortized constant
+//returns the (possibly moved) number,
+//or NULL if the reallocation failed, in that case number is not modified
+static BigInt* internal_reserve(BigInt* number,size_t capacity){
+	if(capacity<=number->capacity){
+		return number;
 	}
+	size_t newCapacity=number->capacity+(number->capacity>>1);
+	if(newCapacity<capacity){
+		newCapacity=capacity;
+	}
+	newCapacity=internal_roundCapacity(newCapacity);
+#ifdef BIG_INT_SINGLE_ALLOCATION
+	number=internal_reallocBlock(number->context,number,number->capacity,newCapacity);
+	if(number){
+		number->data=number->inlineData;
+		number->capacity=newCapacity;
+	}
+	return number;
+#else
+	Limb* tmp;
+	if(number->data==number->inlineData){//move the number out of the inline storage
+		tmp=internal_allocBlock(number->context,newCapacity);
+		if(tmp){
+			memcpy(tmp,number->inlineData,number->size*sizeof(Limb));
+		}
+	}else{
+		tmp=internal_reallocBlock(number->context,number->data,number->capacity,newCapacity);
+	}
+	if(tmp==NULL){
+		return NULL;
+	}
+	number->data=tmp;
+	number->capacity=newCapacity;
+	return number;
+#endif
+}
+/**ensures that a can store numbers with up to capacity ints (32 or 64 bits, see BIG_INT_64BIT_LIMBS) without reallocation,
+ * returns the (possibly moved) number or NULL if the allocation failed (in that case a is not modified)*/
+BigInt* bigIntReserve(BigInt* a,size_t capacity){
+	if(a==NULL||((a==BIG_INT_ZERO||a==BIG_INT_ONE)&&capacity>a->capacity)){
+		return NULL;//the constants cannot be modified
+	}
+	return internal_reserve(a,capacity);
+}
+/**releases memory that a has reserved but currently does not use, returns the (possibly moved) number*/
+BigInt* bigIntShrinkToFit(BigInt* a){
+#ifdef BIG_INT_SINGLE_ALLOCATION
+	size_t capacity=a?internal_roundCapacity(a->size):0;
+	if(a==NULL||a==BIG_INT_ZERO||a==BIG_INT_ONE||a->capacity<=capacity){
+		return a;
+	}
+	BigInt* tmp=internal_reallocBlock(a->context,a,a->capacity,capacity);
+	if(tmp==NULL){
+		return a;//keep the old (larger) block
+	}
+	tmp->data=tmp->inlineData;
+	tmp->capacity=capacity;
+	return tmp;
+#else
+	if(a==NULL||a==BIG_INT_ZERO||a==BIG_INT_ONE||a->data==a->inlineData||a->capacity==a->size){
+		return a;
+	}
+	if(a->size<=BIG_INT_INLINE_SIZE){//move small numbers back to the inline storage
+		if(a->size>0){
+			memcpy(a->inlineData,a->data,a->size*sizeof(Limb));
+		}
+		internal_releaseBlock(a->context,a->data,a->capacity);
+		a->data=a->inlineData;
+		a->capacity=BIG_INT_INLINE_SIZE;
+	}else{
+		size_t capacity=internal_roundCapacity(a->size);
+		if(capacity>=a->capacity){
+			return a;
+		}
+		Limb* tmp=internal_reallocBlock(a->context,a->data,a->capacity,capacity);
+		if(tmp==NULL){
+			return a;//keep the old (larger) buffer
+		}
+		a->data=tmp;
+		a->capacity=capacity;
+	}
+	return a;
+#endif
+}
+
+//prepares dst as destination of a calculation with up to capacity ints,
+//the constants and NULL are replaced with a new number, all other values of dst are reused,
+//a and b are updated if they are the same number as dst (and dst has been moved)
+//returns NULL if the allocation failed, in that case dst is freed
+static BigInt* internal_prepareInto(BigInt* dst,size_t capacity,BigInt** a,BigInt** b){
+	if(dst==NULL||!internal_canConsume(dst)){
+		dst=createBigIntSize(capacity);
+		if(dst){
+			dst->size=0;
+		}
+		return dst;
+	}
+	bool isA=a&&*a==dst,isB=b&&*b==dst;
+	BigInt* tmp=internal_reserve(dst,capacity);
+	if(tmp==NULL){
+		freeBigInt(dst);
+		return NULL;
+	}
+	if(isA){
+		*a=tmp;
+	}
+	if(isB){
+		*b=tmp;
+	}
+	return tmp;
+}
+//replaces dst with the already computed number res (used if the calculation needs temporary numbers anyway)
+static BigInt* internal_moveInto(BigInt* dst,BigInt* res){
+	if(dst!=res){
+		freeBigInt(dst);
+	}
+	return res;
+}
+/**copies the value of src into dst, reusing the memory of dst,
+ * returns the (possibly moved) dst or NULL if the allocation failed*/
+BigInt* copyBigIntInto(BigInt* dst,BigInt* src){
+	if(src==NULL){
+		freeBigInt(dst);
+		return NULL;
+	}
+	dst=internal_prepareInto(dst,src->size,&src,NULL);
+	if(dst&&dst!=src){
+		if(src->size>0){
+			memcpy(dst->data,src->data,src->size*sizeof(Limb));
+		}
+		dst->size=src->size;
+		dst->sgn=src->sgn;
+	}
+	return dst;
 }
 
+//removes leading zeros from number,
+//the memory of number is kept to be reused by later operations (see bigIntShrinkToFit)
 static BigInt* internal_standardizeBigInt(BigInt* number){
 	if(number){
 		if(number->size==0){
 			number->sgn=0;
-			if(number->data){
-				free(number->data);
-				number->data=NULL;
-			}
 		}else if(number->data){
 			assert((number->size)>0);
-			if(number->data[number->size-1]==0){
-				while(number->data[number->size-1]==0&&number->size>=2){
-					number->size--;
-				}
-				if(number->size==1&&number->data[0]==0){
-					number->size=0;
-					free(number->data);
-					number->data=NULL;
-					return number;
-				}
-				if(number->size==0){
-					free(number->data);
-					number->data=NULL;
-				}else{
-					uint32_t * tmp=realloc(number->data,number->size*sizeof(uint32_t));
-					if(tmp){
-						number->data=tmp;
-					}else{
-						freeBigInt(number);
-						return NULL;
-					}
-				}
+			while(number->size>0&&number->data[number->size-1]==0){
+				number->size--;
+			}
+			if(number->size==0){
+				number->sgn=0;
 			}
 		}else{
 			freeBigInt(number);
@@ -238,6 +1982,7 @@ static BigInt* internal_standardizeBigInt(BigInt* number){
 
 
 void printBigIntHex(BigInt* number,bool consume){
+	consume=consume&&internal_canConsume(number);
 	if(number){
 		if(number->sgn){
 			putchar('-');
@@ -273,6 +2018,146 @@ void printBigIntHex(BigInt* number,bool consume){
 	}
 }
 
+#ifdef BIG_INT_64BIT_LIMBS
+//value of max Power of base that is less than or equal to 2^64
+static DoubleLimb internal_maxPowerLimb(int base){
+	switch(base){
+		case 2:  return (DoubleLimb)1<<64;
+		case 3:  return 12157665459056928801u;
+		case 4:  return (DoubleLimb)1<<64;
+		case 5:  return 7450580596923828125u;
+		case 6:  return 4738381338321616896u;
+		case 7:  return 3909821048582988049u;
+		case 8:  return 9223372036854775808u;
+		case 9:  return 12157665459056928801u;
+		case 10: return 10000000000000000000u;
+		case 11: return 5559917313492231481u;
+		case 12: return 2218611106740436992u;
+		case 13: return 8650415919381337933u;
+		case 14: return 2177953337809371136u;
+		case 15: return 6568408355712890625u;
+		case 16: return (DoubleLimb)1<<64;
+		case 17: return 2862423051509815793u;
+		case 18: return 6746640616477458432u;
+		case 19: return 15181127029874798299u;
+		case 20: return 1638400000000000000u;
+		case 21: return 3243919932521508681u;
+		case 22: return 6221821273427820544u;
+		case 23: return 11592836324538749809u;
+		case 24: return 876488338465357824u;
+		case 25: return 1490116119384765625u;
+		case 26: return 2481152873203736576u;
+		case 27: return 4052555153018976267u;
+		case 28: return 6502111422497947648u;
+		case 29: return 10260628712958602189u;
+		case 30: return 15943230000000000000u;
+		case 31: return 787662783788549761u;
+		case 32: return 1152921504606846976u;
+		case 33: return 1667889514952984961u;
+		case 34: return 2386420683693101056u;
+		case 35: return 3379220508056640625u;
+		case 36: return 4738381338321616896u;
+		case 37: return 6582952005840035281u;
+		case 38: return 9065737908494995456u;
+		case 39: return 12381557655576425121u;
+		case 40: return 16777216000000000000u;
+		case 41: return 550329031716248441u;
+		case 42: return 717368321110468608u;
+		case 43: return 929293739471222707u;
+		case 44: return 1196683881290399744u;
+		case 45: return 1532278301220703125u;
+		case 46: return 1951354384207722496u;
+		case 47: return 2472159215084012303u;
+		case 48: return 3116402981210161152u;
+		case 49: return 3909821048582988049u;
+		case 50: return 4882812500000000000u;
+		case 51: return 6071163615208263051u;
+		case 52: return 7516865509350965248u;
+		case 53: return 9269035929372191597u;
+		case 54: return 11384956040305711104u;
+		case 55: return 13931233916552734375u;
+		case 56: return 16985107389382393856u;
+		case 57: return 362033331456891249u;
+		case 58: return 430804206899405824u;
+		case 59: return 511116753300641401u;
+		case 60: return 604661760000000000u;
+		case 61: return 713342911662882601u;
+		case 62: return 839299365868340224u;
+		default: return 0;
+	}
+}
+static BigInt* internal_maxPowerInt(int base){
+	DoubleLimb value=internal_maxPowerLimb(base);
+	return value==0?NULL:internal_createBigIntDoubleLimb(value);
+}
+//max Power of base that is less than or equal to 2^64
+static uint64_t internal_maxPowers(int base){
+	switch(base){
+		case 2:  return 64;
+		case 3:  return 40;
+		case 4:  return 32;
+		case 5:  return 27;
+		case 6:  return 24;
+		case 7:  return 22;
+		case 8:  return 21;
+		case 9:  return 20;
+		case 10: return 19;
+		case 11: return 18;
+		case 12: return 17;
+		case 13: return 17;
+		case 14: return 16;
+		case 15: return 16;
+		case 16: return 16;
+		case 17: return 15;
+		case 18: return 15;
+		case 19: return 15;
+		case 20: return 14;
+		case 21: return 14;
+		case 22: return 14;
+		case 23: return 14;
+		case 24: return 13;
+		case 25: return 13;
+		case 26: return 13;
+		case 27: return 13;
+		case 28: return 13;
+		case 29: return 13;
+		case 30: return 13;
+		case 31: return 12;
+		case 32: return 12;
+		case 33: return 12;
+		case 34: return 12;
+		case 35: return 12;
+		case 36: return 12;
+		case 37: return 12;
+		case 38: return 12;
+		case 39: return 12;
+		case 40: return 12;
+		case 41: return 11;
+		case 42: return 11;
+		case 43: return 11;
+		case 44: return 11;
+		case 45: return 11;
+		case 46: return 11;
+		case 47: return 11;
+		case 48: return 11;
+		case 49: return 11;
+		case 50: return 11;
+		case 51: return 11;
+		case 52: return 11;
+		case 53: return 11;
+		case 54: return 11;
+		case 55: return 11;
+		case 56: return 11;
+		case 57: return 10;
+		case 58: return 10;
+		case 59: return 10;
+		case 60: return 10;
+		case 61: return 10;
+		case 62: return 10;
+		default: return -1;
+	}
+}
+#else
 //value of max Power of base that is less than or equal to 2^32
 static BigInt* internal_maxPowerInt(int base){
 	switch(base){
@@ -407,126 +2292,827 @@ static uint64_t internal_maxPowers(int base){
 	default: return -1;
 	}
 }
+#endif
+
+
+//cache for the powers base^(internal_maxPowers(base)*2^k) used in the divide and conquer string conversions
+//and for their reciprocals used in printing
+//indexed by [base][k], entries are only added with an atomic compare and swap,
+//once published an entry is never modified, so concurrent readers don't need to lock the cache
+static _Atomic(BigInt*) internal_powCache[64][64];
+static _Atomic(BigInt*) internal_powInvCache[64][64];
+
+//publishes value in the given cache entry, if the entry is already set value is freed and the existing entry is returned
+static BigInt* internal_publishCacheEntry(_Atomic(BigInt*)* entry,BigInt* value){
+	BigInt* expected=NULL;
+	if(!atomic_compare_exchange_strong_explicit(entry,&expected,value,
+			memory_order_acq_rel,memory_order_acquire)){
+		//another thread computed the same value
+		freeBigInt(value);
+		return expected;
+	}
+	return value;
+}
+
+static BigInt* internal_cachedPow(int base,int k);
+static BigInt* internal_cachedPowInv(int base,int k);
+
+//computes the value of internal_cachedPow(base,k) that is not yet in the cache
+static BigInt* internal_computePow(int base,int k){
+	BigInt* pow;
+	if(k==0){
+		pow=internal_maxPowerInt(base);
+	}else{
+		BigInt* prev=internal_cachedPow(base,k-1);
+		if(!prev){
+			return NULL;
+		}
+		pow=multBigInt(prev,false,prev,false);
+	}
+	return pow;
+}
+//computes the value of internal_cachedPowInv(base,k) that is not yet in the cache
+static BigInt* internal_computePowInv(int base,int k){
+	BigInt* inv;
+	BigInt* pow=internal_cachedPow(base,k);
+	if(!pow){
+		return NULL;
+	}
+	int64_t n=pow->size;
+	BigInt* one=shiftBigInt(createBigIntInt(1),true,2*INT_BITS*n);//2^(2*INT_BITS*n)
+	if(!one){
+		return NULL;
+	}
+	if(k==0){
+		inv=divBigInt(one,false,pow,false);
+	}else{
+		BigInt* prevInv=internal_cachedPowInv(base,k-1);
+		BigInt* prevPow=internal_cachedPow(base,k-1);
+		if(!(prevInv&&prevPow)){
+			freeBigInt(one);
+			return NULL;
+		}
+		//since pow=prevPow^2 the square of prevInv approximates the first half of the bits of inv
+		inv=shiftBigInt(multBigInt(prevInv,false,prevInv,false),true,INT_BITS*(2*n-4*(int64_t)prevPow->size));
+		//a single Newton step inv=inv+inv*(2^(2*INT_BITS*n)-pow*inv)/2^(2*INT_BITS*n) doubles the number of correct bits
+		BigInt* err=inv?subtBigInt(one,false,multBigInt(pow,false,inv,false),true):NULL;
+		inv=err?addBigInt(inv,true,shiftBigInt(multBigInt(inv,false,err,true),true,-2*INT_BITS*n),true):NULL;
+	}
+	//correct the remaining error of inv
+	BigInt* rem=inv?subtBigInt(one,false,multBigInt(inv,false,pow,false),true):NULL;
+	while(rem&&inv&&rem->sgn){
+		rem=addBigInt(rem,true,pow,false);
+		inv=subtBigInt(inv,true,BIG_INT_ONE,false);
+	}
+	while(rem&&inv&&cmpBigInt(rem,pow)>=0){
+		rem=subtBigInt(rem,true,pow,false);
+		inv=addBigInt(inv,true,BIG_INT_ONE,false);
+	}
+	freeBigInt(one);
+	if(!rem){
+		freeBigInt(inv);
+		return NULL;
+	}
+	freeBigInt(rem);
+	return inv;
+}
+
+//returns base^(internal_maxPowers(base)*2^k), missing entries of the power cache are computed on demand,
+//the returned value is owned by the cache and must not be modified or consumed
+static BigInt* internal_cachedPow(int base,int k){
+	BigInt* pow=atomic_load_explicit(&internal_powCache[base][k],memory_order_acquire);
+	if(pow){
+		return pow;
+	}
+	//cache entries outlive the current computation, so they are always allocated with the default context
+	BigIntContext* context=internal_currentContext;
+	internal_currentContext=&internal_defaultContext;
+	pow=internal_computePow(base,k);
+	internal_currentContext=context;
+	return pow?internal_publishCacheEntry(&internal_powCache[base][k],pow):NULL;
+}
+//returns floor(2^(2*INT_BITS*n)/P) for P=internal_cachedPow(base,k) with n=P->size
+//the returned value is owned by the cache and must not be modified or consumed
+static BigInt* internal_cachedPowInv(int base,int k){
+	BigInt* inv=atomic_load_explicit(&internal_powInvCache[base][k],memory_order_acquire);
+	if(inv){
+		return inv;
+	}
+	BigIntContext* context=internal_currentContext;
+	internal_currentContext=&internal_defaultContext;
+	inv=internal_computePowInv(base,k);
+	internal_currentContext=context;
+	return inv?internal_publishCacheEntry(&internal_powInvCache[base][k],inv):NULL;
+}
+
+/**releases all but the first keep cached powers for the given base,
+ * base 0 trims the caches of all bases
+ * the cache must not be used by other threads while it is trimmed*/
+void bigIntTrimPowerCache(int base,int keep){
+	if(keep<0){
+		keep=0;
+	}
+	for(int b=(base==0?2:base);b<=(base==0?BIGINT_MAX_BASE:base);b++){
+		if(b<2||b>BIGINT_MAX_BASE){
+			return;
+		}
+		for(int k=keep;k<64;k++){
+			freeBigInt(atomic_exchange_explicit(&internal_powCache[b][k],NULL,memory_order_acq_rel));
+			freeBigInt(atomic_exchange_explicit(&internal_powInvCache[b][k],NULL,memory_order_acq_rel));
+		}
+	}
+}
+/**releases all cached powers,
+ * the cache must not be used by other threads while it is released*/
+void bigIntFreePowerCache(void){
+	bigIntTrimPowerCache(0,0);
+}
+
+/*creates a BigInt from a null-terminated string
+ *base should be between 2 and 62*///addLater describe case handling
+BigInt* createBigIntCStr(const char* str,int base){
+	return createBigIntStr(str,strlen(str),base);
+}
+
+//converts a string of digits to a BigInt by processing blocks of internal_maxPowers(base) digits,
+//each block is merged into the preallocated result with a single pass over the data
+//returns NULL if the string contains invalid digits
+static BigInt* internal_parseBlocks(const char* stringValue,size_t stringLen,int base){
+	size_t blockDigits=internal_maxPowers(base);
+	DoubleLimb blockBase=1;
+	for(size_t i=0;i<blockDigits;i++){
+		blockBase*=base;
+	}
+	//each block fits into a single int
+	BigInt* ret=createBigIntSize(stringLen/blockDigits+1);
+	if(!ret){
+		return NULL;
+	}
+	ret->size=0;
+	bool bigBase=base>36;
+	size_t i=0,blockEnd=stringLen%blockDigits;
+	if(blockEnd==0){
+		blockEnd=blockDigits;
+	}
+	while(i<stringLen){
+		DoubleLimb buffer=0;
+		for(;i<blockEnd;i++){
+			uint32_t digit=internal_digitFromChar(stringValue[i],bigBase);
+			if(digit>=base){
+				freeBigInt(ret);
+				return NULL;
+			}
+			buffer=buffer*base+digit;
+		}
+		blockEnd+=blockDigits;
+		//ret=ret*blockBase+block
+		for(size_t j=0;j<ret->size;j++){
+			buffer+=ret->data[j]*blockBase;
+			ret->data[j]=buffer&LIMB_MAX;
+			buffer >>= INT_BITS;
+		}
+		if(buffer!=0){
+			ret->data[ret->size++]=buffer&LIMB_MAX;
+		}
+	}
+	return internal_standardizeBigInt(ret);
+}
+
+//divide and conquer string conversion:
+//splits the string, converts both halves separately and combines them with a cached power of base
+static BigInt* internal_parseDivideAndConquer(const char* stringValue,size_t stringLen,int base){
+	if(stringLen<=PARSE_DC_THRESHOLD){
+		internal_profileBranch(BRANCH_PARSE_BLOCKS);
+		return internal_parseBlocks(stringValue,stringLen,base);
+	}
+	internal_profileBranch(BRANCH_PARSE_SPLIT);
+	size_t blockDigits=internal_maxPowers(base);
+	int k=0;
+	while((blockDigits<<(k+1))<stringLen){
+		k++;
+	}
+	size_t lowLen=blockDigits<<k;
+	BigInt* pow=internal_cachedPow(base,k);
+	if(!pow){
+		return NULL;
+	}
+	BigInt* high=internal_parseDivideAndConquer(stringValue,stringLen-lowLen,base);
+	if(!high){
+		return NULL;
+	}
+	BigInt* low=internal_parseDivideAndConquer(stringValue+(stringLen-lowLen),lowLen,base);
+	if(!low){
+		freeBigInt(high);
+		return NULL;
+	}
+	high=multBigInt(high,true,pow,false);
+	if(!high){
+		freeBigInt(low);
+		return NULL;
+	}
+	return addBigInt(high,true,low,true);
+}
+
+//number of bits per digit if base is a power of 2, 0 otherwise
+static int internal_pow2Bits(int base){
+	switch(base){
+		case 2:  return 1;
+		case 4:  return 2;
+		case 8:  return 3;
+		case 16: return 4;
+		case 32: return 5;
+		default: return 0;
+	}
+}
+
+//converts a string of digits in the base 2^bitsPerDigit to a BigInt,
+//by directly packing the bits of the digits into the data-blocks
+static BigInt* internal_parsePow2(const char* stringValue,size_t stringLen,int base,int bitsPerDigit){
+	if(stringLen==0){
+		return createBigIntInt(0);
+	}
+	BigInt* ret=createBigIntSize((stringLen*bitsPerDigit+INT_BITS-1)/INT_BITS);
+	if(!ret){
+		return NULL;
+	}
+	DoubleLimb buffer=0;
+	int bufferBits=0;
+	size_t j=0;
+	for(size_t i=stringLen;i>0;i--){
+		uint32_t digit=internal_digitFromChar(stringValue[i-1],false);
+		if(digit>=base){
+			freeBigInt(ret);
+			return NULL;
+		}
+		buffer|=((DoubleLimb)digit)<<bufferBits;
+		bufferBits+=bitsPerDigit;
+		if(bufferBits>=INT_BITS){
+			ret->data[j++]=buffer&LIMB_MAX;
+			buffer >>= INT_BITS;
+			bufferBits-=INT_BITS;
+		}
+	}
+	if(bufferBits>0){
+		ret->data[j++]=buffer&LIMB_MAX;
+	}
+	ret->size=j;
+	return internal_standardizeBigInt(ret);
+}
+
+/*creates a BigInt from a string
+ *base should be between 2 and 62*///addLater describe case handling
+static BigInt* internal_createBigIntStr(const char* stringValue,size_t stringLen,int base){
+	if(base<2||base>BIGINT_MAX_BASE){
+		return NULL;
+	}
+	if(stringLen>0&&stringValue[0]=='-'){
+		return negateBigInt(createBigIntStr(stringValue+1,stringLen-1,base),true);
+	}
+	int bitsPerDigit=internal_pow2Bits(base);
+	if(bitsPerDigit>0){
+		internal_profileBranch(BRANCH_PARSE_POW2);
+		return internal_parsePow2(stringValue,stringLen,base,bitsPerDigit);
+	}
+	return internal_parseDivideAndConquer(stringValue,stringLen,base);
+}
+BigInt* createBigIntStr(const char* stringValue,size_t stringLen,int base){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_PARSE,stringLen);
+	BigInt* res=internal_createBigIntStr(stringValue,stringLen,base);
+	internal_leaveOp(scope);
+	return res;
+}
+
+//number of significant bits in the ints of the given array
+static size_t internal_bitLength(Limb* data,size_t size){
+	while(size>0&&data[size-1]==0){
+		size--;
+	}
+	if(size==0){
+		return 0;
+	}
+	size_t bits=(size-1)*INT_BITS;
+	for(Limb top=data[size-1];top!=0;top>>=1){
+		bits++;
+	}
+	return bits;
+}
+
+static const char BIGINT_DIGITS[]="0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+
+//ceil(2^32*log(2)/log(base)) for bases between 2 and 62
+static const uint64_t internal_digitsPerBit[]={0,0,
+		4294967296,2709822658,2147483648,1849741733,1661520156,1529898220,1431655766,1354911329,
+		1292913987,1241523976,1198050830,1160664036,1128071164,1099331346,1073741824,1050766078,
+		1029986702,1011073585,993761859,977836273,963119892,949465784,936750802,924870867,
+		913737343,903274220,893415895,884105414,875293063,866935226,858993460,851433730,
+		844225783,837342624,830760078,824456425,818412085,812609357,807032192,801666002,
+		796497491,791514512,786705943,782061578,777572033,773228661,769023480,764949110,
+		760998713,757165946,753444911,749830123,746316465,742899164,739573757,736336068,
+		733182184,730108433,727111368,724187745,721334514
+};
+
+/**upper bound for the number of chars needed to convert a to a string in the given base,
+ * including the sign and the terminating null-character, returns 0 for invalid bases*/
+size_t bigIntStringSize(BigInt* a,int base){
+	if(base<2||base>BIGINT_MAX_BASE){
+		return 0;
+	}
+	if(!a){
+		return sizeof("(NULL)");
+	}
+	size_t bits=internal_bitLength(a->data,a->size);
+	//bits*log(2)/log(base) split into two parts to prevent overflow
+	size_t digits=(bits>>32)*internal_digitsPerBit[base]+
+			((bits&UINT32_MAX)*internal_digitsPerBit[base]>>32)+1;
+	return digits+2;//sign and null-terminator
+}
 
+//all two digit decimal numbers
+static const char internal_decimalPairs[]=
+		"0001020304050607080910111213141516171819"
+		"2021222324252627282930313233343536373839"
+		"4041424344454647484950515253545556575859"
+		"6061626364656667686970717273747576777879"
+		"8081828384858687888990919293949596979899";
+//all two digit hexadecimal numbers
+static const char internal_hexPairs[]=
+		"000102030405060708090A0B0C0D0E0F101112131415161718191A1B1C1D1E1F"
+		"202122232425262728292A2B2C2D2E2F303132333435363738393A3B3C3D3E3F"
+		"404142434445464748494A4B4C4D4E4F505152535455565758595A5B5C5D5E5F"
+		"606162636465666768696A6B6C6D6E6F707172737475767778797A7B7C7D7E7F"
+		"808182838485868788898A8B8C8D8E8F909192939495969798999A9B9C9D9E9F"
+		"A0A1A2A3A4A5A6A7A8A9AAABACADAEAFB0B1B2B3B4B5B6B7B8B9BABBBCBDBEBF"
+		"C0C1C2C3C4C5C6C7C8C9CACBCCCDCECFD0D1D2D3D4D5D6D7D8D9DADBDCDDDEDF"
+		"E0E1E2E3E4E5E6E7E8E9EAEBECEDEEEFF0F1F2F3F4F5F6F7F8F9FAFBFCFDFEFF";
 
-static void internal_printInt64(BigInt *toPrint, int base,uint64_t width, FILE *target) {
+//writes the decimal digits of data to the chars before buffEnd
+//returns the number of written digits
+static int internal_decimalDigits(uint64_t data,char* buffEnd){
+	int i=0;
+	while(data>=100){
+		uint32_t pair=data%100;
+		data/=100;
+		i+=2;
+		memcpy(buffEnd-i,internal_decimalPairs+2*pair,2);
+	}
+	if(data>=10){
+		i+=2;
+		memcpy(buffEnd-i,internal_decimalPairs+2*data,2);
+	}else if(data>0){
+		buffEnd[-(++i)]='0'+data;
+	}
+	return i;
+}
+
+//writes the digits of toPrint (which has to fit into 64bit) to the chars before end,
+//if width is not 0 the output is padded with zeros to exactly width digits
+//returns a pointer to the first written digit
+static char* internal_printInt64(BigInt *toPrint, int base,uint64_t width, char *end) {
 	uint64_t data =(toPrint->size>0)?toPrint->data[0]:0;
+#ifndef BIG_INT_64BIT_LIMBS
 	if(toPrint->size>1){
 		data |= (((uint64_t) toPrint->data[1]) << INT_BITS);
 	}
-	char buff[64];//buffer big enough to hold all digits
+#endif
 	int i = 0;
-	while (data != 0) {
-		buff[i++] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz"[data % base];
-		data /= base;
-	}
-	while(i<width){
-		putc('0', target);
-		width--;
+	if(base==10){
+		i=internal_decimalDigits(data,end);
+	}else{
+		while (data != 0) {
+			end[-(++i)] = BIGINT_DIGITS[data % base];
+			data /= base;
+		}
 	}
-	while (i > 0) {
-		putc(buff[--i], target);
+	if(i<width){
+		memset(end-width,'0',width-i);
+		i=width;
 	}
+	return end-i;
 }
 
-int printBigInt(BigInt *toPrint, _Bool consume, FILE *target, int base) {
-	if (toPrint) {
-		if (base < 2 || base > BIGINT_MAX_BASE) {
-			return -1; //addLater error codes
-		} //no else
-		if (toPrint->size == 0) {
-			fputs("0", target);
-			return 0;
-		} //no else
-		if (toPrint->sgn) {
-			putc('-', target);
-			toPrint = negateBigInt(toPrint, consume);
-			consume = true;
-		}
-		if (toPrint->size <= 2) {
-			internal_printInt64(toPrint, base, 0,target);
-			if(consume){
-				freeBigInt(toPrint);
+//writes the digits of |toPrint| for the base 2^bitsPerDigit to target,
+//the digits are directly extracted from the data-blocks of toPrint
+//assumes toPrint->size>0, returns a pointer to the char after the last written digit
+static char* internal_printPow2(BigInt *toPrint,int bitsPerDigit,char *target){
+	size_t numDigits=(internal_bitLength(toPrint->data,toPrint->size)+bitsPerDigit-1)/bitsPerDigit;
+	if(bitsPerDigit==4){
+		//convert each byte with a single table lookup
+		char* pos=target+numDigits;
+		size_t fullInts=numDigits/(2*sizeof(Limb));
+		for(size_t j=0;j<fullInts;j++){
+			Limb val=toPrint->data[j];
+			for(int b=0;b<(int)sizeof(Limb);b++){
+				pos-=2;
+				memcpy(pos,internal_hexPairs+2*(val&0xff),2);
+				val>>=8;
 			}
-			return 0;
 		}
-		BigInt* pows[64]; //more than enough buffer
-		int powX = 0;
-		int powCount = 1;
-		BigInt* stack[64]={0};
-		int stackSize = 0;
-		pows[0] = internal_maxPowerInt(base);
-		if (!pows[0]) {
-			if (consume) {
-				freeBigInt(toPrint);
+		if(pos>target){//remaining digits of the highest int
+			Limb val=toPrint->data[fullInts];
+			while(pos>target){
+				*(--pos)=BIGINT_DIGITS[val&0xf];
+				val>>=4;
 			}
-			return -1;
-		}
-		while (2 * pows[powX]->size <= toPrint->size) {
-			pows[powX + 1] = multBigInt(pows[powX], false, pows[powX], false);
-			if (pows[++powX]) {
-				powCount++;
-			} else {
-				while (powCount > 0) {
-					freeBigInt(pows[--powCount]);
-				}
-				if (consume) {
-					freeBigInt(toPrint);
-				}
-				return -1;
+		}
+		return target+numDigits;
+	}
+	uint32_t mask=(1<<bitsPerDigit)-1;
+	DoubleLimb buffer=0;
+	int bufferBits=0;
+	size_t j=0;
+	for(size_t i=numDigits;i>0;i--){
+		if(bufferBits<bitsPerDigit){
+			if(j<toPrint->size){
+				buffer|=((DoubleLimb)toPrint->data[j++])<<bufferBits;
 			}
+			bufferBits+=INT_BITS;
 		}
+		target[i-1]=BIGINT_DIGITS[buffer&mask];
+		buffer >>= bitsPerDigit;
+		bufferBits-=bitsPerDigit;
+	}
+	return target+numDigits;
+}
 
-		DivModResult divMod;
-		bool first=true;
-		while (toPrint) {
-			while (toPrint->size > 2) {
-				assert(powX>=0);
-				divMod = divModBigInt(toPrint, consume, pows[powX--], false, true,true);
-				consume=true;
-				if (divMod.result && divMod.remainder) {
-					toPrint = divMod.result;
-					stack[stackSize++] = divMod.remainder;
-				} else {
-					//division failed
-					freeBigInt(divMod.result);
-					freeBigInt(divMod.remainder);
-					while (powCount > 0) {
-						freeBigInt(pows[--powCount]);
-					}
-					while (stackSize > 0) {
-						freeBigInt(stack[--stackSize]);
-					}
-					return -1;
-				}
+//divides x by P=internal_cachedPow(base,k) with the cached reciprocal of P (Barrett reduction)
+//x is consumed, assumes 0<=x<P^2
+static DivModResult internal_divModCachedPow(BigInt* x,int base,int k){
+	BigInt* pow=internal_cachedPow(base,k);
+	BigInt* inv=internal_cachedPowInv(base,k);
+	if(!(pow&&inv)){
+		freeBigInt(x);
+		return (DivModResult){.result=NULL,.remainder=NULL};
+	}
+	int64_t n=pow->size;
+	//((x>>INT_BITS*(n-1))*inv)>>INT_BITS*(n+1) is at most 2 less than the actual quotient
+	BigInt* q=shiftBigInt(multBigInt(shiftBigInt(x,false,-INT_BITS*(n-1)),true,inv,false),true,-INT_BITS*(n+1));
+	BigInt* r=q?multBigInt(q,false,pow,false):NULL;
+	if(!r){
+		freeBigInt(x);
+		freeBigInt(q);
+		return (DivModResult){.result=NULL,.remainder=NULL};
+	}
+	r=subtBigInt(x,true,r,true);
+	while(r&&q&&cmpBigInt(r,pow)>=0){
+		r=subtBigInt(r,true,pow,false);
+		q=addBigInt(q,true,BIG_INT_ONE,false);
+	}
+	if(!(r&&q)){
+		freeBigInt(r);
+		freeBigInt(q);
+		return (DivModResult){.result=NULL,.remainder=NULL};
+	}
+	return (DivModResult){.result=q,.remainder=r};
+}
+
+static atomic_int internal_conversionThreads=1;
+/**sets the maximum number of threads used to convert a single large number to a string*/
+void bigIntSetConversionThreads(int numThreads){
+	atomic_store(&internal_conversionThreads,numThreads<1?1:numThreads);
+}
+
+typedef struct{
+	BigInt* toPrint;
+	int base;
+	size_t width;
+	char* end;
+	int numThreads;
+	char* start;
+}PrintTask;
+
+static void* internal_printTask(void* task);
+
+//writes the digits of toPrint to the chars before end using a divide and conquer algorithm,
+//toPrint is consumed, if width is not 0 the output is padded with zeros to exactly width digits
+//toPrint is split by the largest cached power P with P^2>toPrint,
+//since the low part has a fixed width, the output region of both parts is known
+//before any digit is written and the two parts can be converted on different threads
+//returns a pointer to the first written digit or NULL if the conversion failed
+static char* internal_printDivideAndConquer(BigInt *toPrint, int base, size_t width, char *end, int numThreads) {
+	if (toPrint->size*INT_BITS <= 64) {
+		internal_profileBranch(BRANCH_PRINT_INT64);
+		end = internal_printInt64(toPrint, base, width, end);
+		freeBigInt(toPrint);
+		return end;
+	}
+	int k = 0;
+	BigInt* next;
+	while ((next = internal_cachedPow(base, k + 1)) && cmpBigInt(next, toPrint) <= 0) {
+		k++;
+	}
+	if (!next) {
+		freeBigInt(toPrint);
+		return NULL;
+	}
+	if (numThreads > 1 && width == 0) {
+		//compute all reciprocals needed by the worker threads in advance
+		for (int i = 0; i <= k; i++) {
+			if (!internal_cachedPowInv(base, i)) {
+				freeBigInt(toPrint);
+				return NULL;
 			}
-			if(first){
-				internal_printInt64(toPrint, base,0, target);
-				first = toPrint->size==0;
-			}else{
-				internal_printInt64(toPrint, base,internal_maxPowers(base)<<(powX+1), target);
+		}
+	}
+	DivModResult divMod = internal_divModCachedPow(toPrint, base, k);
+	if (!(divMod.result && divMod.remainder)) {
+		//division failed
+		return NULL;
+	}
+	internal_profileBranch(BRANCH_PRINT_SPLIT);
+	size_t lowWidth = internal_maxPowers(base) << k;
+	PrintTask high={.toPrint=divMod.result,.base=base,.width=width > lowWidth ? width - lowWidth : 0,
+			.end=end-lowWidth,.numThreads=numThreads/2};
+	pthread_t highThread;
+	if (numThreads > 1 && divMod.result->size >= PARALLEL_PRINT_THRESHOLD &&
+			pthread_create(&highThread, NULL, &internal_printTask, &high) == 0) {
+		internal_profileBranch(BRANCH_PRINT_THREAD);
+		char* start = internal_printDivideAndConquer(divMod.remainder, base, lowWidth, end, numThreads - numThreads/2);
+		pthread_join(highThread, NULL);
+		return start ? high.start : NULL;
+	}
+	high.numThreads = numThreads;
+	internal_printTask(&high);
+	if (!high.start) {
+		freeBigInt(divMod.remainder);
+		return NULL;
+	}
+	return internal_printDivideAndConquer(divMod.remainder, base, lowWidth, end, numThreads) ? high.start : NULL;
+}
+
+static void* internal_printTask(void* task){
+	PrintTask* printTask=task;
+	printTask->start=internal_printDivideAndConquer(printTask->toPrint,printTask->base,printTask->width,
+			printTask->end,printTask->numThreads);
+	return NULL;
+}
+
+/**writes a in the given base as null-terminated string to buffer,
+ * bufferSize has to be at least bigIntStringSize(a,base),
+ * returns the length of the string or 0 if the conversion failed
+  arguments marked with consume will be deleted or overwritten by the calculation*/
+static size_t internal_bigIntToString(BigInt* a,bool consume,char* buffer,size_t bufferSize,int base){
+	consume=consume&&internal_canConsume(a);
+	size_t needed=bigIntStringSize(a,base);
+	if(needed==0||needed>bufferSize){
+		if(consume){
+			freeBigInt(a);
+		}
+		return 0;
+	}
+	if(!a){
+		strcpy(buffer,"(NULL)");
+		return sizeof("(NULL)")-1;
+	}
+	char* end=buffer;
+	if(a->size==0){
+		*(end++)='0';
+		if(consume){
+			freeBigInt(a);
+		}
+	}else{
+		if(a->sgn){
+			*(end++)='-';
+		}
+		int bitsPerDigit=internal_pow2Bits(base);
+		if(bitsPerDigit>0){
+			internal_profileBranch(BRANCH_PRINT_POW2);
+			end=internal_printPow2(a,bitsPerDigit,end);
+			if(consume){
+				freeBigInt(a);
 			}
-			freeBigInt(toPrint);
-			toPrint=NULL;
-			if (stackSize > 0) {
-				toPrint = stack[--stackSize];
-				stack[stackSize]=NULL;
-				while (powX+1<powCount && cmpBigInt(pows[powX+1],toPrint)<0) {
-					powX++;
+		}else{
+			if(!consume){
+				a=cloneBigInt(a);
+				if(!a){
+					return 0;
 				}
 			}
+			a->sgn=0;
+			int numThreads=atomic_load(&internal_conversionThreads);
+			//the parts of a are passed to other threads, which must not share a context like an arena
+			//with this thread, so a parallel conversion allocates with the default context
+			BigIntContext* context=internal_currentContext;
+			if(numThreads>1){
+				internal_currentContext=&internal_defaultContext;
+			}
+			//digits are written right-aligned to the end of the buffer and then moved to the front
+			char* start=internal_printDivideAndConquer(a,base,0,buffer+bufferSize-1,numThreads);
+			internal_currentContext=context;
+			if(!start){
+				return 0;
+			}
+			size_t len=buffer+bufferSize-1-start;
+			memmove(end,start,len);
+			end+=len;
+		}
+	}
+	*end='\0';
+	return end-buffer;
+}
+size_t bigIntToString(BigInt* a,bool consume,char* buffer,size_t bufferSize,int base){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_TO_STRING,internal_operandSize(a,NULL));
+	size_t res=internal_bigIntToString(a,consume,buffer,bufferSize,base);
+	internal_leaveOp(scope);
+	return res;
+}
+/**converts a to a null-terminated string in the given base,
+ * the string is allocated with malloc and has to be freed by the caller,
+ * returns NULL if the conversion failed
+  arguments marked with consume will be deleted or overwritten by the calculation*/
+char* bigIntToStringAlloc(BigInt* a,bool consume,int base){
+	size_t size=bigIntStringSize(a,base);
+	char* buffer=size>0?malloc(size):NULL;
+	if(!buffer){
+		if(consume){
+			freeBigInt(a);
 		}
-		while (powCount > 0) {
-			freeBigInt(pows[--powCount]);
+		return NULL;
+	}
+	if(bigIntToString(a,consume,buffer,size,base)==0){
+		free(buffer);
+		return NULL;
+	}
+	return buffer;
+}
+
+static int internal_printBigInt(BigInt *toPrint, _Bool consume, FILE *target, int base) {
+	size_t size=bigIntStringSize(toPrint,base);
+	char* str=size>0?internal_scratch(size):NULL;
+	if(!str||bigIntToString(toPrint,consume,str,size,base)==0){
+		if(!str&&consume){
+			freeBigInt(toPrint);
+		}
+		return -1; //addLater error codes
+	}
+	fputs(str,target);
+	internal_trimScratch();
+	return 0;
+}
+int printBigInt(BigInt *toPrint, _Bool consume, FILE *target, int base){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_PRINT,internal_operandSize(toPrint,NULL));
+	int res=internal_printBigInt(toPrint,consume,target,base);
+	internal_leaveOp(scope);
+	return res;
+}
+
+static bool internal_isLittleEndianHost(void){
+	const uint32_t one=1;
+	return *((const uint8_t*)&one)==1;
+}
+static uint32_t internal_swapBytes32(uint32_t val){
+	return (val>>24)|((val>>8)&0xff00)|((val<<8)&0xff0000)|(val<<24);
+}
+static Limb internal_swapBytes(Limb val){
+#ifdef BIG_INT_64BIT_LIMBS
+	return (((Limb)internal_swapBytes32(val&UINT32_MAX))<<32)|internal_swapBytes32(val>>32);
+#else
+	return internal_swapBytes32(val);
+#endif
+}
+//loads/stores an int from/to the numBytes (<=sizeof(Limb)) bytes at the given position
+//the bytes are interpreted in the order specified by bigEndian
+static Limb internal_loadInt(const uint8_t* src,size_t numBytes,bool bigEndian){
+	Limb val=0;
+	if(bigEndian){
+		memcpy(((uint8_t*)&val)+(sizeof(Limb)-numBytes),src,numBytes);
+		return internal_isLittleEndianHost()?internal_swapBytes(val):val;
+	}else{
+		memcpy(&val,src,numBytes);
+		return internal_isLittleEndianHost()?val:internal_swapBytes(val);
+	}
+}
+static void internal_storeInt(uint8_t* target,size_t numBytes,Limb val,bool bigEndian){
+	if(bigEndian){
+		val=internal_isLittleEndianHost()?internal_swapBytes(val):val;
+		memcpy(target,((uint8_t*)&val)+(sizeof(Limb)-numBytes),numBytes);
+	}else{
+		val=internal_isLittleEndianHost()?val:internal_swapBytes(val);
+		memcpy(target,&val,numBytes);
+	}
+}
+//replaces the ints in data with their two-complement
+static void internal_negateInts(Limb* data,size_t size){
+	size_t i=0;
+	for(;i<size;i++){
+		data[i]=-data[i];
+		if(data[i]){
+			i++;
+			break;
+		}
+	}//after first non-zero element ~ instead of -
+	for(;i<size;i++){
+		data[i]=~data[i];
+	}
+}
+
+/**creates a BigInt from the given array of bytes,
+ * flags determines the byte-order and sign handling of the input*/
+BigInt* createBigIntBytes(const void* bytes,size_t numBytes,int flags){
+	if(numBytes==0){
+		return createBigIntInt(0);
+	}
+	const uint8_t* src=bytes;
+	bool bigEndian=(flags&BIG_INT_BYTES_BIG_ENDIAN)!=0;
+	bool negative=(flags&BIG_INT_BYTES_TWOS_COMPLEMENT)&&(src[bigEndian?0:numBytes-1]&0x80);
+	size_t fullInts=numBytes/sizeof(Limb),tailBytes=numBytes%sizeof(Limb);
+	BigInt* ret=createBigIntSize(fullInts+(tailBytes?1:0));
+	if(!ret){
+		return NULL;
+	}
+	if(!bigEndian&&internal_isLittleEndianHost()){
+		//memory layout of input matches memory layout of BigInt
+		memcpy(ret->data,src,fullInts*sizeof(Limb));
+	}else if(bigEndian){
+		for(size_t i=0;i<fullInts;i++){
+			ret->data[i]=internal_loadInt(src+numBytes-(i+1)*sizeof(Limb),sizeof(Limb),true);
 		}
-		return 0;
 	}else{
-		fputs("(NULL)",target);
+		for(size_t i=0;i<fullInts;i++){
+			ret->data[i]=internal_loadInt(src+i*sizeof(Limb),sizeof(Limb),false);
+		}
+	}
+	if(tailBytes){
+		Limb tail=internal_loadInt(bigEndian?src:src+fullInts*sizeof(Limb),tailBytes,bigEndian);
+		if(negative){//sign-extend
+			tail|=LIMB_MAX<<(8*tailBytes);
+		}
+		ret->data[fullInts]=tail;
+	}
+	if(negative){
+		internal_negateInts(ret->data,ret->size);
+		ret->sgn=LIMB_MAX;
+	}
+	return internal_standardizeBigInt(ret);
+}
+
+/**number of bytes needed to store a in the format given by flags*/
+size_t bigIntByteLength(BigInt* a,int flags){
+	if(!a){
 		return 0;
 	}
+	size_t bits=internal_bitLength(a->data,a->size);
+	if(flags&BIG_INT_BYTES_TWOS_COMPLEMENT){
+		if(a->sgn){
+			//-2^k needs only k+1 bits in two-complement
+			size_t i=0;
+			while(a->data[i]==0){
+				i++;
+			}
+			if(i==a->size-1&&(a->data[i]&(a->data[i]-1))==0){
+				bits--;
+			}
+		}
+		bits++;//sign bit
+	}
+	return (bits+7)/8;
 }
 
-//TODO bigIntBytes()
+/**writes a into target in the format given by flags,
+ * returns the number of bytes needed to store a,
+ * if this is larger than targetLen nothing is written to target,
+ * otherwise the remaining bytes of target are filled with the (sign-extended) value*/
+size_t bigIntBytes(BigInt* a,void* target,size_t targetLen,int flags){
+	size_t needed=bigIntByteLength(a,flags);
+	if(!a||needed>targetLen){
+		return needed;
+	}
+	uint8_t* dest=target;
+	bool bigEndian=(flags&BIG_INT_BYTES_BIG_ENDIAN)!=0;
+	bool negative=(flags&BIG_INT_BYTES_TWOS_COMPLEMENT)&&a->sgn;
+	size_t numInts=(needed+sizeof(Limb)-1)/sizeof(Limb);
+	if(numInts>a->size){
+		numInts=a->size;
+	}
+	size_t numBytes=numInts*sizeof(Limb);
+	if(numBytes>targetLen){
+		numBytes=targetLen;
+	}
+	if(!negative&&!bigEndian&&internal_isLittleEndianHost()){
+		//memory layout of output matches memory layout of BigInt
+		memcpy(dest,a->data,numBytes);
+	}else{
+		bool hadNZ=false;
+		for(size_t i=0;i*sizeof(Limb)<numBytes;i++){
+			Limb val=a->data[i];
+			if(negative){
+				if(hadNZ){
+					val=~val;
+				}else{
+					hadNZ=val!=0;
+					val=-val;
+				}
+			}
+			size_t len=numBytes-i*sizeof(Limb);
+			if(len>sizeof(Limb)){
+				len=sizeof(Limb);
+			}
+			internal_storeInt(bigEndian?dest+targetLen-i*sizeof(Limb)-len:dest+i*sizeof(Limb),
+					len,val,bigEndian);
+		}
+	}
+	memset(bigEndian?dest:dest+numBytes,negative?0xff:0,targetLen-numBytes);
+	return needed;
+}
 
 /**returns the sign of a (a<0?-1:a>0?1:0)*/
 int bigIntSgn(BigInt* a){
@@ -541,20 +3127,7 @@ int bigIntSgn(BigInt* a){
  * returns negative value if |a|<|b|; 0 if |a|==|b| and positive value if |a|>|b|*/
 static int cmpBigIntAbs(BigInt* a,BigInt* b){
 	if(a&&b){
-		if( a->size > b->size ){
-			return 1;//a>b if sgnA=sgnB=1
-		}else if( a->size < b->size ){
-			return -1;//a<b if sgnA=sgnB=1
-		}else{
-			//block-wise compare form high to low locks
-			for(size_t i=a->size-1;i!=SIZE_MAX;i--){//! >=0 not possible for uint
-				if(a->data[i] < b -> data[i]){
-					return -1;
-				}else if(a->data[i] > b -> data[i]){
-					return 1;
-				}
-			}
-		}
+		return internal_cmp(a->data,a->size,b->data,b->size);
 	}
 	return 0;
 }
@@ -597,13 +3170,15 @@ int cmpBigIntInt(BigInt* a,int64_t b){
 	}else{//sgnA == sgnB
 		assert(a->size>0);
 		uint64_t intVal;
-		if(a->size>2){
+		if(a->size*INT_BITS>64){
 			return sgnA;
-		}else if(a->size==2){
-			intVal=(((uint64_t)a->data[1])<<INT_BITS)|a->data[0];
-		}else if(a->size==1){
-			intVal=a->data[0];
 		}
+		intVal=a->data[0];
+#ifndef BIG_INT_64BIT_LIMBS
+		if(a->size==2){
+			intVal|=((uint64_t)a->data[1])<<INT_BITS;
+		}
+#endif
 		if(intVal<(uint64_t)b){
 			return -sgnA;
 		}else if(intVal>(uint64_t)b){
@@ -615,33 +3190,34 @@ int cmpBigIntInt(BigInt* a,int64_t b){
 
 /**flips all bits in a,
  * if mutable is true, the argument a is directly modified*/
-BigInt* notBigInt(BigInt* a,bool consumeA){
+static BigInt* internal_notBigInt(BigInt* a,bool consumeA){
+	consumeA=consumeA&&internal_canConsume(a);
 	if(!consumeA){
 		a=cloneBigInt(a);
 	}
 	if(a){
 		if(a->size>0){
 			bool searchNZ=true;
-			uint64_t buffer=a->data[0]+(a->sgn==0?1:-1);
-			a->data[0]=buffer&UINT32_MAX;
+			DoubleLimb buffer=a->data[0]+(a->sgn==0?1:-1);
+			a->data[0]=buffer&LIMB_MAX;
 			searchNZ=(a->data[0]==0);
 			buffer >>= INT_BITS;
 			for(size_t i=1;buffer!=0&&i<a->size;i++){
 				buffer+=a->data[i];
-				a->data[i]=buffer&UINT32_MAX;
+				a->data[i]=buffer&LIMB_MAX;
 				if(searchNZ){
 					searchNZ=(a->data[i]==0);
 				}
 				buffer >>= INT_BITS;
 			}
 			if(buffer!=0){
-				uint32_t* tmp=realloc(a->data,(a->size+1)*sizeof(uint32_t));
+				BigInt* tmp=internal_reserve(a,a->size+1);
 				if(tmp==NULL){
 					freeBigInt(a);
 					return NULL;
 				}else{
-					a->data=tmp;
-					a->data[a->size++]=buffer&UINT32_MAX;
+					a=tmp;
+					a->data[a->size++]=buffer&LIMB_MAX;
 				}
 			}
 			return negateBigInt(internal_standardizeBigInt(a),true);
@@ -652,9 +3228,15 @@ BigInt* notBigInt(BigInt* a,bool consumeA){
 	}
 	return NULL;
 }
+BigInt* notBigInt(BigInt* a,bool consumeA){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_NOT,internal_operandSize(a,NULL));
+	BigInt* res=internal_notBigInt(a,consumeA);
+	internal_leaveOp(scope);
+	return res;
+}
 
 //helper for logical operations
-static uint32_t internal_2compBlock(BigInt* bigInt,size_t i,bool* hadNZ){
+static Limb internal_2compBlock(BigInt* bigInt,size_t i,bool* hadNZ){
 	if(i<bigInt->size){
 		if(bigInt->sgn){
 			if(*hadNZ){
@@ -674,26 +3256,19 @@ static uint32_t internal_2compBlock(BigInt* bigInt,size_t i,bool* hadNZ){
 //assumes that all arguments are not NULL,
 //and that target->size == big->size >= small->size
 static void internal_unsavelogicalOp(BigInt* target,BigInt* big,BigInt* small,
-		uint32_t (*f)(uint32_t,uint32_t),bool isAnd){
+		Limb (*f)(Limb,Limb),bool isAnd){
 	size_t i=0;
 	bool hadNZB=false,hadNZS=false;
 	for(;i<small->size;i++){
 	   target->data[i]=f(internal_2compBlock(big,i,&hadNZB),internal_2compBlock(small,i,&hadNZS));
 	}
-	uint32_t defVal=small->sgn;
+	Limb defVal=small->sgn;
 	//TODO replace isAnd with tail0,tail1 [val,op,tail]
 	if(isAnd==(defVal==0)){//TODO handle xor differently
 		if(defVal==0){
 			target->size=i;
-			uint32_t* tmp=realloc(target->data,i*sizeof(uint32_t));
-			if(tmp){
-				target->data=tmp;
-			}else{
-				target->data=NULL;
-				return;
-			}
 		}else{
-			memset(i+(target->data),UINT32_MAX,(big->size - small->size)*sizeof(uint32_t));
+			memset(i+(target->data),0xff,(big->size - small->size)*sizeof(Limb));
 			target->size=big->size;
 		}
 	}else{//addLater shortcut
@@ -717,18 +3292,20 @@ static void internal_unsavelogicalOp(BigInt* target,BigInt* big,BigInt* small,
 	}
 }
 
-static uint32_t internal_uint32and(uint32_t a,uint32_t b){
+static Limb internal_limbAnd(Limb a,Limb b){
 	return a&b;
 }
-static uint32_t internal_uint32or(uint32_t a,uint32_t b){
+static Limb internal_limbOr(Limb a,Limb b){
 	return a|b;
 }
 
-static uint32_t internal_uint32xor(uint32_t a,uint32_t b){
+static Limb internal_limbXor(Limb a,Limb b){
 	return a^b;
 }
 static BigInt* internal_logicalOp(BigInt* a,bool consumeA,BigInt* b,bool consumeB,
-		uint32_t (*op)(uint32_t,uint32_t),bool isAnd){
+		Limb (*op)(Limb,Limb),bool isAnd){
+	consumeA=consumeA&&internal_canConsume(a);
+	consumeB=consumeB&&internal_canConsume(b);
 	if(a&&b){
 		if(a==b){//can only consume one
 			consumeA&=consumeB;//only consume if both can be consumed
@@ -744,9 +3321,9 @@ static BigInt* internal_logicalOp(BigInt* a,bool consumeA,BigInt* b,bool consume
 				a=internal_standardizeBigInt(a);
 				return a;
 			}else if(consumeB){
-				uint32_t* tmp=realloc(b->data,(a->size)*sizeof(uint32_t));
+				BigInt* tmp=internal_reserve(b,a->size);
 				if(tmp){
-					b->data=tmp;
+					b=tmp;
 					internal_unsavelogicalOp(b,a,b,op,isAnd);
 				}else{
 					freeBigInt(b);
@@ -771,9 +3348,9 @@ static BigInt* internal_logicalOp(BigInt* a,bool consumeA,BigInt* b,bool consume
 				b=internal_standardizeBigInt(b);
 				return b;
 			}else if(consumeA){
-				uint32_t* tmp=realloc(a->data,(b->size)*sizeof(uint32_t));
+				BigInt* tmp=internal_reserve(a,b->size);
 				if(tmp){
-					a->data=tmp;
+					a=tmp;
 					internal_unsavelogicalOp(a,b,a,op,isAnd);
 				}else{
 					freeBigInt(a);
@@ -802,22 +3379,63 @@ static BigInt* internal_logicalOp(BigInt* a,bool consumeA,BigInt* b,bool consume
 /*logical and of a and b
   arguments marked with consume will be deleted or overwritten by the calculation*/
 BigInt* andBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
-	return internal_logicalOp(a,consumeA,b,consumeB,&internal_uint32and,true);
+	OperationScope scope=internal_enterOp(BIG_INT_OP_AND,internal_operandSize(a,b));
+	BigInt* res=internal_logicalOp(a,consumeA,b,consumeB,&internal_limbAnd,true);
+	internal_leaveOp(scope);
+	return res;
 }
 /*logical or of a and b
   arguments marked with consume will be deleted or overwritten by the calculation**/
 BigInt* orBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
-	return internal_logicalOp(a,consumeA,b,consumeB,&internal_uint32or,false);
+	OperationScope scope=internal_enterOp(BIG_INT_OP_OR,internal_operandSize(a,b));
+	BigInt* res=internal_logicalOp(a,consumeA,b,consumeB,&internal_limbOr,false);
+	internal_leaveOp(scope);
+	return res;
 }
 /*logical exclusive or of a and b
   arguments marked with consume will be deleted or overwritten by the calculation*/
 BigInt* xorBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
-	return internal_logicalOp(a,consumeA,b,consumeB,&internal_uint32xor,false);
+	OperationScope scope=internal_enterOp(BIG_INT_OP_XOR,internal_operandSize(a,b));
+	BigInt* res=internal_logicalOp(a,consumeA,b,consumeB,&internal_limbXor,false);
+	internal_leaveOp(scope);
+	return res;
+}
+
+static BigInt* internal_logicalOpInto(BigInt* dst,BigInt* a,BigInt* b,
+		Limb (*op)(Limb,Limb),bool isAnd){
+	if(!(a&&b)){
+		freeBigInt(dst);
+		return NULL;
+	}
+	if(a->size<b->size){//len a>=len b
+		BigInt* tmp=a;
+		a=b;
+		b=tmp;
+	}
+	dst=internal_prepareInto(dst,a->size,&a,&b);
+	if(dst==NULL){
+		return NULL;
+	}
+	internal_unsavelogicalOp(dst,a,b,op,isAnd);
+	return internal_standardizeBigInt(dst);
+}
+/*stores the logical and of a and b in dst, reusing the memory of dst*/
+BigInt* andBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	return internal_logicalOpInto(dst,a,b,&internal_limbAnd,true);
+}
+/*stores the logical or of a and b in dst, reusing the memory of dst*/
+BigInt* orBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	return internal_logicalOpInto(dst,a,b,&internal_limbOr,false);
+}
+/*stores the logical exclusive or of a and b in dst, reusing the memory of dst*/
+BigInt* xorBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	return internal_logicalOpInto(dst,a,b,&internal_limbXor,false);
 }
 
 /*returns a cop of a that is shifted by the given amount,
  * if amount is positive a is shifted to the left otherwise to the right */
-BigInt* shiftBigInt(BigInt* a,bool consumeA,int64_t amount){
+static BigInt* internal_shiftBigInt(BigInt* a,bool consumeA,int64_t amount){
+	consumeA=consumeA&&internal_canConsume(a);
 	if(a){
 		if(amount==0||a->size==0){
 			return consumeA?a:cloneBigInt(a);//no shift
@@ -830,165 +3448,130 @@ BigInt* shiftBigInt(BigInt* a,bool consumeA,int64_t amount){
 					neg=true;
 				}
 				amount=-amount;
-				size_t shiftBlocks=amount>>5;// amount/32
+				size_t shiftBlocks=amount/INT_BITS;
 				if(shiftBlocks>=a->size){
 					if(consumeA){
 						freeBigInt(a);
 					}
 					return createBigIntInt(neg?-1:0);
 				}
-				uint8_t shiftBits=amount&0x1f;// amount%32
-				if(consumeA){
-					memmove(a->data,a->data+shiftBlocks,(a->size-shiftBlocks)*sizeof(uint32_t));
-					uint32_t* tmp=realloc(a->data,(a->size-shiftBlocks)*sizeof(uint32_t));
-					if(tmp){
-						a->data=tmp;
-						a->size=a->size-shiftBlocks;
-					}else{
-						freeBigInt(a);
-						return NULL;
-					}
-				}else{
-					uint32_t* tmp=malloc((a->size-shiftBlocks)*sizeof(uint32_t));
-					if(tmp){
-						memcpy(tmp,a->data+shiftBlocks,(a->size-shiftBlocks)*sizeof(uint32_t));
-						a=createBigIntInts(a->sgn,tmp,a->size-shiftBlocks);
-						if(!a){
-							free(tmp);
-							return NULL;
-						}
+				uint8_t shiftBits=amount%INT_BITS;
+				BigInt* target=a;
+				if(!consumeA){
+					target=createBigIntSize(a->size-shiftBlocks);
+					if(target){
+						target->sgn=a->sgn;
 					}else{
 						return NULL;
 					}
 				}
 				if(shiftBits!=0){
-					shiftBits = INT_BITS - shiftBits;
-					uint64_t buffer=0;
-					for(size_t i=a->size-1;i!=SIZE_MAX;i--){
-						buffer|=((uint64_t)a->data[i])<<shiftBits;
-						a->data[i] = (buffer >> INT_BITS) & UINT32_MAX;
-						buffer <<= INT_BITS;
-					}
+					internal_rshift(target->data,a->data+shiftBlocks,a->size-shiftBlocks,shiftBits);
+				}else{
+					internal_copy(target->data,a->data+shiftBlocks,a->size-shiftBlocks);
 				}
+				target->size=a->size-shiftBlocks;
+				a=target;
 				if(neg){//(-a)>>b = - ((a-1)>>b +1)
 					a=subtBigInt(a,true,createBigIntInt(1),true);
 				}
 			}else{
-				size_t shiftBlocks=amount>>5;// amount/32
-				uint8_t shiftBits=amount&0x1f;// amount%32
+				size_t shiftBlocks=amount/INT_BITS;
+				uint8_t shiftBits=amount%INT_BITS;
+				BigInt* target;
 				if(consumeA){
-					uint32_t* tmp=realloc(a->data,(a->size+shiftBlocks+(shiftBits!=0?1:0))*sizeof(uint32_t));
-					if(tmp){
-						memmove(tmp+shiftBlocks,tmp,a->size*sizeof(uint32_t));
-						a->data=tmp;
-						a->size=a->size+shiftBlocks;
-					}else{
+					target=internal_reserve(a,a->size+shiftBlocks+(shiftBits!=0?1:0));
+					if(!target){
 						freeBigInt(a);
 						return NULL;
 					}
+					a=target;
 				}else{
-					uint32_t* tmp=malloc((a->size+shiftBlocks+(shiftBits!=0?1:0))*sizeof(uint32_t));
-					if(tmp){
-						memcpy(tmp+shiftBlocks,a->data,a->size*sizeof(uint32_t));
-						a=createBigIntInts(a->sgn,tmp,a->size+shiftBlocks);
-						if(!a){
-							free(tmp);
-							return NULL;
-						}
+					target=createBigIntSize(a->size+shiftBlocks+(shiftBits!=0?1:0));
+					if(target){
+						target->sgn=a->sgn;
 					}else{
 						return NULL;
 					}
 				}
-				memset(a->data,0,shiftBlocks*sizeof(uint32_t));
+				//the ints are moved upwards, so the data of a can be shifted in place
+				Limb out=0;
 				if(shiftBits!=0){
-					uint64_t buffer=0;
-					for(size_t i=shiftBlocks;i<a->size;i++){
-						buffer|=((uint64_t)a->data[i])<<shiftBits;
-						a->data[i]=buffer&UINT32_MAX;
-						buffer >>= INT_BITS;
-					}
-					if(buffer!=0){
-						a->data[a->size++]=buffer&UINT32_MAX;
-					}
+					out=internal_lshift(target->data+shiftBlocks,a->data,a->size,shiftBits);
+				}else{
+					internal_copy(target->data+shiftBlocks,a->data,a->size);
 				}
+				memset(target->data,0,shiftBlocks*sizeof(Limb));
+				target->size=a->size+shiftBlocks;
+				if(out!=0){
+					target->data[target->size++]=out;
+				}
+				a=target;
 			}
 			return internal_standardizeBigInt(a);
 		}
 	}
 	return NULL;
 }
+BigInt* shiftBigInt(BigInt* a,bool consumeA,int64_t amount){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_SHIFT,internal_operandSize(a,NULL));
+	BigInt* res=internal_shiftBigInt(a,consumeA,amount);
+	internal_leaveOp(scope);
+	return res;
+}
+
+/*stores a shifted by the given amount in dst, reusing the memory of dst*/
+BigInt* shiftBigIntInto(BigInt* dst,BigInt* a,int64_t amount){
+	dst=copyBigIntInto(dst,a);
+	return dst?shiftBigInt(dst,true,amount):NULL;
+}
 
 /*negates toNegate,
   arguments marked with consume will be deleted or overwritten by the calculation*/
-BigInt* negateBigInt(BigInt* toNegate,bool consumeArg){
+static BigInt* internal_negateBigInt(BigInt* toNegate,bool consumeArg){
+	consumeArg=consumeArg&&internal_canConsume(toNegate);
 	if(!consumeArg){
 		toNegate=cloneBigInt(toNegate);
 	}//no else
 	if(toNegate){
 		if(toNegate->size>0){//dont negate 0
-			toNegate->sgn^=UINT32_MAX;
+			toNegate->sgn^=LIMB_MAX;
 		}
 		return toNegate;
 	}
 	return NULL;
 }
+BigInt* negateBigInt(BigInt* toNegate,bool consumeArg){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_NEGATE,internal_operandSize(toNegate,NULL));
+	BigInt* res=internal_negateBigInt(toNegate,consumeArg);
+	internal_leaveOp(scope);
+	return res;
+}
 
-//assumes target,big,small!=NULL, target->capacity >= big->size >= small->size
+//assumes target,big,small!=NULL, target->capacity > big->size >= small->size
 //the sign values are ignored in the calculation
 static void internal_unsaveAdd(BigInt* target,BigInt* big,BigInt* small){
-	uint64_t carry=0;
-	size_t i=0;
-	for(;i<small->size;i++){
-		carry+=((uint64_t)big->data[i])+small->data[i];
-		target->data[i]=carry&UINT32_MAX;
-		carry >>= INT_BITS;
-	}
-	for(;i<big->size;i++){
-		carry+=big->data[i];
-		target->data[i]=carry&UINT32_MAX;
-		carry >>= INT_BITS;
-	}
+	Limb carry=internal_add(target->data,big->data,big->size,small->data,small->size);
+	size_t i=big->size;
 	if(carry!=0){
-		uint32_t* tmp=realloc(target->data,(i+1)*sizeof(uint32_t));
-		if(tmp){
-			target->data=tmp;
-			target->data[i++]=carry&UINT32_MAX;
-		}else{
-			free(target->data);
-			target->data=NULL;
-		}
+		target->data[i++]=carry;
 	}
 	target->size=i;
 }
 //assumes target,big,small!=NULL, target->capacity >= big->size, |big| >= |small|
 //the sign values are ignored in the calculation
 static void internal_unsaveSubt(BigInt* target,BigInt* big,BigInt* small){
-	int64_t carry=0;
-	size_t i=0;
-	for(;i<small->size;i++){
-		carry+=big->data[i];
-		carry-=small->data[i];
-		target->data[i]=carry&UINT32_MAX;
-		carry >>= INT_BITS;
-		if(carry&0x80000000){
-			carry|=0xffffffff00000000;
-		}
-	}
-	for(;i<big->size;i++){
-		carry+=big->data[i];
-		target->data[i]=carry&UINT32_MAX;
-		carry >>= INT_BITS;
-		if(carry&0x80000000){
-			carry|=0xffffffff00000000;
-		}
-	}
-	target->size=i;
-	assert(carry==0);
+	Limb borrow=internal_sub(target->data,big->data,big->size,small->data,small->size);
+	target->size=big->size;
+	assert(borrow==0);
+	(void)borrow;
 }
 
 /*adds a to b
   arguments marked with consume will be deleted or overwritten by the calculation*/
-BigInt* addBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+static BigInt* internal_addBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	consumeA=consumeA&&internal_canConsume(a);
+	consumeB=consumeB&&internal_canConsume(b);
 	if(a&&b){
 		if(a==b){//can only consume one
 			consumeA&=consumeB;//only consume if both can be consumed
@@ -1006,13 +3589,24 @@ BigInt* addBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 				}
 			}//len a>=len b
 			if(consumeA){
-				tmp=a;
+				tmp=internal_reserve(a,a->size+1);
+				if(tmp){
+					if(b==a){//a may have been moved
+						b=tmp;
+					}
+					a=tmp;
+				}else{
+					freeBigInt(a);
+					if(consumeB){
+						freeBigInt(b);
+					}
+					return NULL;
+				}
 			}else{
 				if(consumeB){
-					uint32_t* tmpP=realloc(b->data,(a->size+1)*sizeof(uint32_t));
-					if(tmpP){
-						b->data=tmpP;
-						tmp=b;
+					tmp=internal_reserve(b,a->size+1);
+					if(tmp){
+						b=tmp;
 						consumeB=false;//b should not be deleted
 					}else{
 						freeBigInt(b);
@@ -1047,10 +3641,9 @@ BigInt* addBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 				tmp=a;
 			}else{
 				if(consumeB){
-					uint32_t* tmpP=realloc(b->data,a->size*sizeof(uint32_t));
-					if(tmpP){
-						b->data=tmpP;
-						tmp=b;
+					tmp=internal_reserve(b,a->size);
+					if(tmp){
+						b=tmp;
 						tmp->sgn=a->sgn;
 						consumeB=false;//b should not be deleted
 					}else{
@@ -1079,244 +3672,734 @@ BigInt* addBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 	}
 	return NULL;
 }
+BigInt* addBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_ADD,internal_operandSize(a,b));
+	BigInt* res=internal_addBigInt(a,consumeA,b,consumeB);
+	internal_leaveOp(scope);
+	return res;
+}
 
 
 /**subtracts b from a
   arguments marked with consume will be deleted or overwritten by the calculation  */
 BigInt* subtBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
-	return addBigInt(a,consumeA,negateBigInt(b,consumeB),true);
-}
-
-static void internal_sqOverflow(BigInt *val, size_t target, uint64_t buffer
-		,uint64_t overflow) {
-	val->data[target++] = buffer & UINT32_MAX;
-	buffer >>= INT_BITS;
-	while (overflow != 0) {
-		buffer += overflow & UINT32_MAX;
-		overflow >>= INT_BITS;
-		buffer += val->data[target];
-		val->data[target++] = buffer & UINT32_MAX;
-		buffer >>= INT_BITS;
-	}
-	while (buffer != 0) {
-		buffer += val->data[target];
-		val->data[target++] = buffer & UINT32_MAX;
-		buffer >>= INT_BITS;
-	}
-}
-static void internal_inPlaceSquare(BigInt* val){
-	uint64_t buffer, overflow;
-	bool canOverflow;
-	size_t N=val->size-1;
-	//iterate through all pairs (i,j), 0<=i,j<=N in order of descending i+j
-	for(size_t s=0;s<N;s++){
-		buffer=overflow=0;
-		for(size_t i=0;i<=s;i++){
-			canOverflow=buffer>>63;
-			buffer+=((uint64_t)val->data[N-i])*val->data[N-(s-i)];
-			if(canOverflow&&(buffer>>63==0)){
-				overflow++;
-			}
-		}
-		internal_sqOverflow(val, 2*N-s, buffer, overflow);
+	OperationScope scope=internal_enterOp(BIG_INT_OP_SUBT,internal_operandSize(a,b));
+	BigInt* res=addBigInt(a,consumeA,negateBigInt(b,consumeB),true);
+	internal_leaveOp(scope);
+	return res;
+}
+
+//adds b (negated if negateB is set) to a and stores the result in dst
+static BigInt* internal_addInto(BigInt* dst,BigInt* a,BigInt* b,bool negateB){
+	if(!(a&&b)){
+		freeBigInt(dst);
+		return NULL;
 	}
-	for(size_t s=N;s!=SIZE_MAX;s--){
-		buffer=overflow=0;
-		for(size_t i=0;i<=s;i++){
-			canOverflow=buffer>>63;
-			buffer+=((uint64_t)val->data[i])*val->data[s-i];
-			if(canOverflow&&(buffer>>63==0)){
-				overflow++;
-			}
-		}
-		internal_sqOverflow(val, s, buffer, overflow);
+	Limb sgnA=a->sgn,sgnB=b->size==0?0:negateB?~b->sgn:b->sgn;
+	if(a->size<b->size){//len a>=len b
+		BigInt* tmp=a;
+		a=b;
+		b=tmp;
+		Limb tmpSgn=sgnA;
+		sgnA=sgnB;
+		sgnB=tmpSgn;
+	}
+	dst=internal_prepareInto(dst,a->size+1,&a,&b);
+	if(dst==NULL){
+		return NULL;
+	}
+	if(sgnA==sgnB){
+		internal_unsaveAdd(dst,a,b);
+		dst->sgn=sgnA;
+	}else if(cmpBigIntAbs(a,b)>=0){
+		internal_unsaveSubt(dst,a,b);
+		dst->sgn=sgnA;
+	}else{
+		internal_unsaveSubt(dst,b,a);
+		dst->sgn=sgnB;
 	}
-	val->size*=2;
+	return internal_standardizeBigInt(dst);
+}
+/*stores a+b in dst, reusing the memory of dst*/
+BigInt* addBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	return internal_addInto(dst,a,b,false);
+}
+/*stores a-b in dst, reusing the memory of dst*/
+BigInt* subtBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	return internal_addInto(dst,a,b,true);
 }
 
 static void internal_unsaveMult(BigInt* target,BigInt* left,BigInt* right){
 	target->data[left->size+right->size-1]=0;
 	target->sgn=(left->sgn)^(right->sgn);
 	if(right==target){//algorithm only works of right!=target
-		if(left==target){
-			internal_inPlaceSquare(target);
-			return;
-		}
+		assert(left!=target);//squares are computed by internal_squareBigInt
 		BigInt* tmp=left;
 		left=right;
 		right=tmp;
 	}
-	uint64_t buffer,tmp;
-	for(size_t l=left->size-1;l!=SIZE_MAX;l--){
-		for(size_t r=right->size-1;r!=SIZE_MAX;r--){
-			buffer=((uint64_t)left->data[l])*right->data[r];
-			tmp=l+r;
-			if(r==0||l==(left->size-1)){
-				target->data[tmp++]=buffer&UINT32_MAX;
-			}else{
-				buffer+=target->data[tmp];
-				target->data[tmp++]=buffer&UINT32_MAX;
+	internal_mulBasecase(target->data,left->data,left->size,right->data,right->size);
+	target->size=left->size+right->size;
+}
+
+//target[0..an+bn)=a*b with the Karatsuba multiplication algorithm, target must not overlap a or b,
+//the scratch memory is taken from the block cache of the calling thread,
+//returns false if the allocation failed
+static bool internal_karatsubaInto(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	BigIntContext* context=internal_currentContext;
+	size_t capacity=internal_roundCapacity(internal_karatsubaScratch(an>bn?an:bn,KARATSUBA_THRESHOLD));
+	Limb* scratch=internal_allocBlock(context,capacity);
+	if(!scratch){
+		return false;
+	}
+	internal_karatsubaMulN(target,a,an,b,bn,scratch);
+	internal_releaseBlock(context,scratch,capacity);
+	return true;
+}
+static bool internal_mulInto(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn);
+
+//the Toom-Cook algorithms split the factors into parts of k ints,
+//evaluate them at a few points, multiply the values and interpolate the product from these values,
+//the highest parts of both factors must not be empty
+static bool internal_useToom3(size_t an,size_t bn,bool square){
+	if(square){
+		return an>=TOOM3_SQR_THRESHOLD&&an>2*((an+2)/3);
+	}
+	return bn>=TOOM3_THRESHOLD&&bn>2*((an+2)/3);
+}
+static bool internal_useToom4(size_t an,size_t bn,bool square){
+	if(square){
+		return an>=TOOM4_SQR_THRESHOLD&&an>3*((an+3)/4);
+	}
+	return bn>=TOOM4_THRESHOLD&&bn>3*((an+3)/4);
+}
+//size of the parts in the Toom-3.2 algorithm
+static size_t internal_toom32Split(size_t an,size_t bn){
+	size_t k=(an+2)/3;
+	return bn>2*k?(bn+1)/2:k;
+}
+static bool internal_useToom32(size_t an,size_t bn){
+	size_t k=internal_toom32Split(an,bn);
+	return bn>=TOOM32_THRESHOLD&&an>2*k&&bn>k;
+}
+//adds c[0..cn) to target[offset..n), the sum has to fit into target
+static void internal_addAt(Limb* target,size_t n,size_t offset,const Limb* c,size_t cn){
+	Limb carry=internal_add(target+offset,target+offset,n-offset,c,internal_normSize(c,cn));
+	assert(carry==0);
+	(void)carry;
+}
+//target[0..vn)=(v1+vm1)/2 and vm1[0..vn)=(v1-vm1)/2, where vm1 is negative if neg is true
+static void internal_toomSplitPm(Limb* v1,Limb* vm1,size_t vn,bool neg){
+	Limb carry=neg?internal_addN(vm1,v1,vm1,vn):internal_subN(vm1,v1,vm1,vn);
+	carry+=internal_lshift(v1,v1,vn,1);
+	carry+=internal_subN(v1,v1,vm1,vn);
+	assert(carry==0);
+	(void)carry;
+	internal_rshift(v1,v1,vn,1);
+	internal_rshift(vm1,vm1,vn,1);
+}
+
+//target[0..an+bn)=a*b with the Toom-Cook 3-way algorithm (evaluation at 0, 1, -1, 2 and infinity),
+//assumes internal_useToom3(an,bn), if a==b and an==bn the square is computed,
+//target must not overlap a or b, returns false if an allocation failed
+static bool internal_toom3(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	bool square=a==b&&an==bn;
+	size_t k=(an+2)/3,highA=an-2*k,highB=bn-2*k,highN=highA+highB,n=an+bn;
+	assert(highA>=1&&highA<=k&&highB>=1&&highB<=k);
+	//values of the product polynomial at 1, -1 and 2 (2k+2 ints each) and the values of the factors
+	size_t vn=2*k+2;
+	BigIntContext* context=internal_currentContext;
+	size_t capacity=internal_roundCapacity(3*vn+4*(k+1));
+	Limb* scratch=internal_allocBlock(context,capacity);
+	if(!scratch){
+		return false;
+	}
+	Limb* v1=scratch;
+	Limb* vm1=v1+vn;
+	Limb* v2=vm1+vn;
+	Limb* evalA=v2+vn;
+	Limb* evalMA=evalA+k+1;
+	Limb* evalB=square?evalA:evalMA+k+1;
+	Limb* evalMB=square?evalMA:evalB+k+1;
+	bool ok;
+	//a(1)=a0+a1+a2, a(-1)=a0-a1+a2
+	evalA[k]=internal_add(evalA,a,k,a+2*k,highA);
+	bool neg=internal_absDiff(evalMA,evalA,k+1,a+k,k);
+	evalA[k]+=internal_addN(evalA,evalA,a+k,k);
+	if(square){//a(-1)^2 is positive
+		neg=false;
+	}else{
+		evalB[k]=internal_add(evalB,b,k,b+2*k,highB);
+		neg^=internal_absDiff(evalMB,evalB,k+1,b+k,k);
+		evalB[k]+=internal_addN(evalB,evalB,b+k,k);
+	}
+	ok=internal_mulInto(v1,evalA,k+1,evalB,k+1)&&internal_mulInto(vm1,evalMA,k+1,evalMB,k+1);
+	//a(2)=a0+2*a1+4*a2
+	internal_copy(evalA,a,k);
+	evalA[k]=internal_addMul1(evalA,a+k,k,2);
+	internal_add1(evalA+highA,evalA+highA,k+1-highA,internal_addMul1(evalA,a+2*k,highA,4));
+	if(!square){
+		internal_copy(evalB,b,k);
+		evalB[k]=internal_addMul1(evalB,b+k,k,2);
+		internal_add1(evalB+highB,evalB+highB,k+1-highB,internal_addMul1(evalB,b+2*k,highB,4));
+	}
+	ok=ok&&internal_mulInto(v2,evalA,k+1,evalB,k+1);
+	//c0=a0*b0 and c4=a2*b2 are written to their final position
+	ok=ok&&internal_mulInto(target,a,k,b,k)&&internal_mulInto(target+4*k,a+2*k,highA,b+2*k,highB);
+	if(!ok){
+		internal_releaseBlock(context,scratch,capacity);
+		return false;
+	}
+	const Limb* c0=target;
+	const Limb* c4=target+4*k;
+	//interpolation, all intermediate values are non-negative
+	internal_toomSplitPm(v1,vm1,vn,neg);//v1=c0+c2+c4, vm1=c1+c3
+	Limb borrow=internal_sub(v1,v1,vn,c0,2*k);
+	borrow+=internal_sub(v1,v1,vn,c4,highN);//v1=c2
+	//v2=c0+2*c1+4*c2+8*c3+16*c4
+	borrow+=internal_sub(v2,v2,vn,c0,2*k);
+	borrow+=internal_subMul1(v2,v1,vn,4);
+	borrow+=internal_sub1(v2+highN,v2+highN,vn-highN,internal_subMul1(v2,c4,highN,16));
+	borrow+=internal_subMul1(v2,vm1,vn,2);//v2=6*c3
+	internal_rshift(v2,v2,vn,1);
+	internal_divExact1(v2,v2,vn,3);//v2=c3
+	borrow+=internal_subN(vm1,vm1,v2,vn);//vm1=c1
+	assert(borrow==0);
+	(void)borrow;
+	memset(target+2*k,0,2*k*sizeof(Limb));
+	internal_addAt(target,n,k,vm1,vn);
+	internal_addAt(target,n,2*k,v1,vn);
+	internal_addAt(target,n,3*k,v2,vn);
+	internal_releaseBlock(context,scratch,capacity);
+	return true;
+}
+
+//target[0..an+bn)=a*b with the unbalanced Toom-3.2 algorithm (evaluation at 0, 1, -1 and infinity),
+//a is split into three parts and b into two parts of k ints, assumes internal_useToom32(an,bn),
+//target must not overlap a or b, returns false if an allocation failed
+static bool internal_toom32(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	size_t k=internal_toom32Split(an,bn),highA=an-2*k,highB=bn-k,n=an+bn;
+	assert(highA>=1&&highA<=k&&highB>=1&&highB<=k);
+	//values of the product polynomial at 1 and -1 (2k+2 ints each) and the values of the factors
+	size_t vn=2*k+2;
+	BigIntContext* context=internal_currentContext;
+	size_t capacity=internal_roundCapacity(2*vn+4*(k+1));
+	Limb* scratch=internal_allocBlock(context,capacity);
+	if(!scratch){
+		return false;
+	}
+	Limb* v1=scratch;
+	Limb* vm1=v1+vn;
+	Limb* evalA=vm1+vn;
+	Limb* evalMA=evalA+k+1;
+	Limb* evalB=evalMA+k+1;
+	Limb* evalMB=evalB+k+1;
+	//a(1)=a0+a1+a2, a(-1)=a0-a1+a2, b(1)=b0+b1, b(-1)=b0-b1
+	evalA[k]=internal_add(evalA,a,k,a+2*k,highA);
+	bool neg=internal_absDiff(evalMA,evalA,k+1,a+k,k);
+	evalA[k]+=internal_addN(evalA,evalA,a+k,k);
+	evalB[k]=internal_add(evalB,b,k,b+k,highB);
+	neg^=internal_absDiff(evalMB,b,k,b+k,highB);
+	vm1[2*k+1]=0;
+	//c0=a0*b0 and c3=a2*b1 are written to their final position
+	bool ok=internal_mulInto(v1,evalA,k+1,evalB,k+1)&&internal_mulInto(vm1,evalMA,k+1,evalMB,k)&&
+		internal_mulInto(target,a,k,b,k)&&internal_mulInto(target+3*k,a+2*k,highA,b+k,highB);
+	if(!ok){
+		internal_releaseBlock(context,scratch,capacity);
+		return false;
+	}
+	//interpolation, all intermediate values are non-negative
+	internal_toomSplitPm(v1,vm1,vn,neg);//v1=c0+c2, vm1=c1+c3
+	Limb borrow=internal_sub(v1,v1,vn,target,2*k);//v1=c2
+	borrow+=internal_sub(vm1,vm1,vn,target+3*k,highA+highB);//vm1=c1
+	assert(borrow==0);
+	(void)borrow;
+	memset(target+2*k,0,k*sizeof(Limb));
+	internal_addAt(target,n,k,vm1,vn);
+	internal_addAt(target,n,2*k,v1,vn);
+	internal_releaseBlock(context,scratch,capacity);
+	return true;
+}
+
+//target[0..an+bn)=a*b with the Toom-Cook 4-way algorithm (evaluation at 0, 1, -1, 2, -2, 1/2 and infinity),
+//assumes internal_useToom4(an,bn), if a==b and an==bn the square is computed,
+//target must not overlap a or b, returns false if an allocation failed
+static bool internal_toom4(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	bool square=a==b&&an==bn;
+	size_t k=(an+3)/4,highA=an-3*k,highB=bn-3*k,highN=highA+highB,n=an+bn;
+	assert(highA>=1&&highA<=k&&highB>=1&&highB<=k);
+	//values of the product polynomial at 1, -1, 2, -2 and 1/2 (multiplied by 64) and the values of the factors
+	size_t vn=2*k+2;
+	BigIntContext* context=internal_currentContext;
+	size_t capacity=internal_roundCapacity(5*vn+5*(k+1));
+	Limb* scratch=internal_allocBlock(context,capacity);
+	if(!scratch){
+		return false;
+	}
+	Limb* v1=scratch;
+	Limb* vm1=v1+vn;
+	Limb* v2=vm1+vn;
+	Limb* vm2=v2+vn;
+	Limb* vh=vm2+vn;
+	Limb* odd=vh+vn;
+	Limb* evalA=odd+k+1;
+	Limb* evalMA=evalA+k+1;
+	Limb* evalB=square?evalA:evalMA+k+1;
+	Limb* evalMB=square?evalMA:evalB+k+1;
+	bool ok,neg;
+	//a(1)=(a0+a2)+(a1+a3), a(-1)=(a0+a2)-(a1+a3)
+	for(int i=0;i<(square?1:2);i++){
+		const Limb* x=i==0?a:b;
+		size_t high=i==0?highA:highB;
+		Limb* plus=i==0?evalA:evalB;
+		Limb* minus=i==0?evalMA:evalMB;
+		odd[k]=internal_add(odd,x+k,k,x+3*k,high);
+		plus[k]=internal_addN(plus,x,x+2*k,k);
+		bool negX=internal_absDiff(minus,plus,k+1,odd,k+1);
+		neg=i==0?negX:neg^negX;
+		internal_addN(plus,plus,odd,k+1);
+	}
+	ok=internal_mulInto(v1,evalA,k+1,evalB,k+1)&&internal_mulInto(vm1,evalMA,k+1,evalMB,k+1);
+	bool neg1=neg&&!square;
+	//a(2)=(a0+4*a2)+(2*a1+8*a3), a(-2)=(a0+4*a2)-(2*a1+8*a3)
+	for(int i=0;i<(square?1:2);i++){
+		const Limb* x=i==0?a:b;
+		size_t high=i==0?highA:highB;
+		Limb* plus=i==0?evalA:evalB;
+		Limb* minus=i==0?evalMA:evalMB;
+		odd[k]=internal_mul1(odd,x+k,k,2);
+		internal_add1(odd+high,odd+high,k+1-high,internal_addMul1(odd,x+3*k,high,8));
+		internal_copy(plus,x,k);
+		plus[k]=internal_addMul1(plus,x+2*k,k,4);
+		bool negX=internal_absDiff(minus,plus,k+1,odd,k+1);
+		neg=i==0?negX:neg^negX;
+		internal_addN(plus,plus,odd,k+1);
+	}
+	ok=ok&&internal_mulInto(v2,evalA,k+1,evalB,k+1)&&internal_mulInto(vm2,evalMA,k+1,evalMB,k+1);
+	bool neg2=neg&&!square;
+	//8*a(1/2)=8*a0+4*a1+2*a2+a3
+	for(int i=0;i<(square?1:2);i++){
+		const Limb* x=i==0?a:b;
+		size_t high=i==0?highA:highB;
+		Limb* plus=i==0?evalA:evalB;
+		plus[k]=internal_mul1(plus,x,k,8);
+		plus[k]+=internal_addMul1(plus,x+k,k,4);
+		plus[k]+=internal_addMul1(plus,x+2*k,k,2);
+		internal_add(plus,plus,k+1,x+3*k,high);
+	}
+	ok=ok&&internal_mulInto(vh,evalA,k+1,evalB,k+1);
+	//c0=a0*b0 and c6=a3*b3 are written to their final position
+	ok=ok&&internal_mulInto(target,a,k,b,k)&&internal_mulInto(target+6*k,a+3*k,highA,b+3*k,highB);
+	if(!ok){
+		internal_releaseBlock(context,scratch,capacity);
+		return false;
+	}
+	const Limb* c0=target;
+	const Limb* c6=target+6*k;
+	//interpolation, all intermediate values are non-negative
+	internal_toomSplitPm(v1,vm1,vn,neg1);//v1=c0+c2+c4+c6, vm1=c1+c3+c5
+	internal_toomSplitPm(v2,vm2,vn,neg2);//v2=c0+4*c2+16*c4+64*c6, vm2=2*c1+8*c3+32*c5
+	internal_rshift(vm2,vm2,vn,1);
+	Limb borrow=internal_sub(v1,v1,vn,c0,2*k);
+	borrow+=internal_sub(v1,v1,vn,c6,highN);//v1=c2+c4
+	borrow+=internal_sub(v2,v2,vn,c0,2*k);
+	borrow+=internal_sub1(v2+highN,v2+highN,vn-highN,internal_subMul1(v2,c6,highN,64));
+	borrow+=internal_subMul1(v2,v1,vn,4);//v2=12*c4
+	internal_rshift(v2,v2,vn,2);
+	internal_divExact1(v2,v2,vn,3);//v2=c4
+	borrow+=internal_subN(v1,v1,v2,vn);//v1=c2
+	//vh=64*c0+32*c1+16*c2+8*c3+4*c4+2*c5+c6
+	borrow+=internal_sub1(vh+2*k,vh+2*k,vn-2*k,internal_subMul1(vh,c0,2*k,64));
+	borrow+=internal_subMul1(vh,v1,vn,16);
+	borrow+=internal_subMul1(vh,v2,vn,4);
+	borrow+=internal_sub(vh,vh,vn,c6,highN);
+	internal_rshift(vh,vh,vn,1);//vh=16*c1+4*c3+c5
+	borrow+=internal_subN(vm2,vm2,vm1,vn);
+	internal_divExact1(vm2,vm2,vn,3);//vm2=c3+5*c5
+	borrow+=internal_lshift(vm1,vm1,vn,4);
+	borrow+=internal_subN(vm1,vm1,vh,vn);
+	internal_divExact1(vm1,vm1,vn,3);//vm1=4*c3+5*c5
+	borrow+=internal_subN(vm1,vm1,vm2,vn);
+	internal_divExact1(vm1,vm1,vn,3);//vm1=c3
+	borrow+=internal_subN(vm2,vm2,vm1,vn);
+	internal_divExact1(vm2,vm2,vn,5);//vm2=c5
+	borrow+=internal_subMul1(vh,vm1,vn,4);
+	borrow+=internal_subN(vh,vh,vm2,vn);
+	internal_rshift(vh,vh,vn,4);//vh=c1
+	assert(borrow==0);
+	(void)borrow;
+	memset(target+2*k,0,4*k*sizeof(Limb));
+	internal_addAt(target,n,k,vh,vn);
+	internal_addAt(target,n,2*k,v1,vn);
+	internal_addAt(target,n,3*k,vm1,vn);
+	internal_addAt(target,n,4*k,v2,vn);
+	internal_addAt(target,n,5*k,vm2,vn);
+	internal_releaseBlock(context,scratch,capacity);
+	return true;
+}
+
+//multiplication with number theoretic transforms (NTT) modulo three primes below 2^30,
+//the factors are split into 32bit pieces, the convolution of the pieces is computed modulo each prime
+//and the exact coefficients (below 2^86) are recovered with the chinese remainder theorem,
+//the arithmetic modulo the primes uses the Montgomery representation x*2^32 mod p
+typedef struct{
+	uint32_t p;
+	//-p^-1 mod 2^32
+	uint32_t negInverse;
+	//2^64 mod p, converts numbers to the Montgomery representation
+	uint32_t r2;
+	//primitive root modulo p
+	uint32_t root;
+}NttPrime;
+#define NTT_PRIME_COUNT 3
+static const uint32_t NTT_PRIMES[NTT_PRIME_COUNT]={998244353,469762049,167772161};
+//the transform length is limited by the coefficient size: length/2 products of two pieces have to be less than
+//the product of the primes, this also keeps it below the largest power of two dividing p-1 for all primes
+static const unsigned NTT_MAX_LOG_LENGTH=22;
+#define NTT_PIECES (INT_BITS/32)
+
+static NttPrime internal_nttPrime(uint32_t p){
+	uint32_t inverse=p;
+	for(int bits=3;bits<32;bits*=2){
+		inverse*=2-p*inverse;
+	}
+	return (NttPrime){.p=p,.negInverse=-inverse,.r2=(uint32_t)((UINT64_MAX%p+1)%p),.root=3};
+}
+//the primes are below 2^30, so values in (-p,p) are reduced with the sign bit instead of a
+//(badly predictable) branch
+static inline uint32_t internal_nttCorrect(const NttPrime* m,uint32_t x){
+	return x+(m->p&-(x>>31));
+}
+//x*2^-32 mod p for x<p*2^32
+static inline uint32_t internal_nttReduce(const NttPrime* m,uint64_t x){
+	uint32_t q=(uint32_t)x*m->negInverse;
+	uint32_t r=(uint32_t)((x+(uint64_t)q*m->p)>>32);
+	return internal_nttCorrect(m,r-m->p);
+}
+static inline uint32_t internal_nttMul(const NttPrime* m,uint32_t a,uint32_t b){
+	return internal_nttReduce(m,(uint64_t)a*b);
+}
+static inline uint32_t internal_nttAdd(const NttPrime* m,uint32_t a,uint32_t b){
+	return internal_nttCorrect(m,a+b-m->p);
+}
+static inline uint32_t internal_nttSub(const NttPrime* m,uint32_t a,uint32_t b){
+	return internal_nttCorrect(m,a-b);
+}
+//x in Montgomery representation
+static inline uint32_t internal_nttToMontgomery(const NttPrime* m,uint32_t x){
+	return internal_nttReduce(m,(uint64_t)x*m->r2);
+}
+//base^e for base in Montgomery representation
+static uint32_t internal_nttPow(const NttPrime* m,uint32_t base,uint64_t e){
+	uint32_t res=internal_nttToMontgomery(m,1);
+	while(e!=0){
+		if(e&1){
+			res=internal_nttMul(m,res,base);
+		}
+		base=internal_nttMul(m,base,base);
+		e>>=1;
+	}
+	return res;
+}
+//roots[len+j]=w^j for j<len, where w is a root of unity of order 2*len, for all powers of two len<n,
+//the inverse roots w^-j are used if inverse is true
+static void internal_nttRoots(const NttPrime* m,uint32_t* roots,size_t n,bool inverse){
+	size_t half=n/2;
+	uint64_t e=(m->p-1)/n;
+	uint32_t w=internal_nttPow(m,internal_nttToMontgomery(m,m->root),inverse?(m->p-1)-e:e);
+	roots[half]=internal_nttToMontgomery(m,1);
+	for(size_t j=1;j<half;j++){
+		roots[half+j]=internal_nttMul(m,roots[half+j-1],w);
+	}
+	for(size_t len=half/2;len>0;len>>=1){
+		for(size_t j=0;j<len;j++){
+			roots[len+j]=roots[2*len+2*j];
+		}
+	}
+}
+//forward transform (decimation in frequency), the result is in bit reversed order
+static void internal_nttForward(const NttPrime* prime,uint32_t* a,size_t n,const uint32_t* roots){
+	//local copy, otherwise the prime is reloaded after every store to a
+	const NttPrime local=*prime;
+	const NttPrime* m=&local;
+	for(size_t len=n/2;len>0;len>>=1){
+		for(size_t i=0;i<n;i+=2*len){
+			for(size_t j=0;j<len;j++){
+				uint32_t u=a[i+j],v=a[i+j+len];
+				a[i+j]=internal_nttAdd(m,u,v);
+				a[i+j+len]=internal_nttMul(m,internal_nttSub(m,u,v),roots[len+j]);
 			}
-			buffer >>= INT_BITS;
-			while(buffer!=0){
-				buffer+=target->data[tmp];
-				target->data[tmp++]=buffer&UINT32_MAX;
-				buffer >>= INT_BITS;
+		}
+	}
+}
+//inverse of internal_nttForward without the division by n (decimation in time, input in bit reversed order),
+//inverseRoots are the roots computed by internal_nttRoots with inverse=true
+static void internal_nttInverse(const NttPrime* prime,uint32_t* a,size_t n,const uint32_t* inverseRoots){
+	const NttPrime local=*prime;
+	const NttPrime* m=&local;
+	for(size_t len=1;len<n;len<<=1){
+		for(size_t i=0;i<n;i+=2*len){
+			for(size_t j=0;j<len;j++){
+				uint32_t u=a[i+j],v=internal_nttMul(m,a[i+j+len],inverseRoots[len+j]);
+				a[i+j]=internal_nttAdd(m,u,v);
+				a[i+j+len]=internal_nttSub(m,u,v);
 			}
 		}
 	}
-	target->size=left->size+right->size;
+}
+//loads the 32bit pieces of a[0..an) into target[0..n) in Montgomery representation
+static void internal_nttLoad(const NttPrime* m,uint32_t* target,size_t n,const Limb* a,size_t an){
+	size_t pieces=an*NTT_PIECES;
+	for(size_t k=0;k<pieces;k++){
+		target[k]=internal_nttToMontgomery(m,(uint32_t)(a[k/NTT_PIECES]>>(32*(k%NTT_PIECES))));
+	}
+	memset(target+pieces,0,(n-pieces)*sizeof(uint32_t));
+}
+//target[0..n)=convolution of the pieces of a and b modulo m (in the standard representation),
+//if b is NULL the pieces of a are squared, work has to contain n values if b is not NULL
+static void internal_nttConvolution(const NttPrime* m,uint32_t* target,uint32_t* work,uint32_t* roots,size_t n,
+		const Limb* a,size_t an,const Limb* b,size_t bn){
+	internal_nttRoots(m,roots,n,false);
+	internal_nttLoad(m,target,n,a,an);
+	internal_nttForward(m,target,n,roots);
+	if(b){
+		internal_nttLoad(m,work,n,b,bn);
+		internal_nttForward(m,work,n,roots);
+		for(size_t i=0;i<n;i++){
+			target[i]=internal_nttMul(m,target[i],work[i]);
+		}
+	}else{//the transform of a is reused
+		for(size_t i=0;i<n;i++){
+			target[i]=internal_nttMul(m,target[i],target[i]);
+		}
+	}
+	internal_nttRoots(m,roots,n,true);
+	internal_nttInverse(m,target,n,roots);
+	//multiplying with the standard representation of 1/n removes the factor 2^32 of the Montgomery representation
+	uint32_t nInverse=internal_nttReduce(m,internal_nttPow(m,internal_nttToMontgomery(m,(uint32_t)(n%m->p)),m->p-2));
+	for(size_t i=0;i<n;i++){
+		target[i]=internal_nttMul(m,target[i],nInverse);
+	}
+}
+//returns log2 of the transform length for factors with an and bn ints, or 0 if they are too large for the NTT
+static unsigned internal_nttLogLength(size_t an,size_t bn){
+	size_t coefficients=(an+bn)*NTT_PIECES-1;
+	unsigned logLength=1;
+	while(((size_t)1<<logLength)<coefficients){
+		if(++logLength>NTT_MAX_LOG_LENGTH){
+			return 0;
+		}
+	}
+	return logLength;
+}
+static bool internal_useNtt(size_t an,size_t bn,bool square){
+	return (square?an>=NTT_SQR_THRESHOLD:bn>=NTT_THRESHOLD)&&internal_nttLogLength(an,bn)!=0;
+}
+//target[0..an+bn)=a*b with the NTT multiplication, if a==b and an==bn the transform of a is only computed once,
+//assumes internal_useNtt(an,bn), target must not overlap a or b, returns false if an allocation failed
+static bool internal_nttMulInto(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	bool square=a==b&&an==bn;
+	size_t n=(size_t)1<<internal_nttLogLength(an,bn);
+	//roots, the residues modulo the three primes and the transform of b
+	size_t words=(square?4:5)*n;
+	BigIntContext* context=internal_currentContext;
+	size_t capacity=internal_roundCapacity((words*sizeof(uint32_t)+sizeof(Limb)-1)/sizeof(Limb));
+	uint32_t* scratch=internal_allocBlock(context,capacity);
+	if(!scratch){
+		return false;
+	}
+	uint32_t* roots=scratch;
+	uint32_t* residues[NTT_PRIME_COUNT]={scratch+n,scratch+2*n,scratch+3*n};
+	uint32_t* work=square?NULL:scratch+4*n;
+	NttPrime m[NTT_PRIME_COUNT];
+	for(int i=0;i<NTT_PRIME_COUNT;i++){
+		m[i]=internal_nttPrime(NTT_PRIMES[i]);
+		internal_nttConvolution(&m[i],residues[i],work,roots,n,a,an,square?NULL:b,bn);
+	}
+	//chinese remainder theorem (Garner's algorithm): c=x0+x1*p0+x2*p0*p1
+	uint32_t p0=m[0].p,p1=m[1].p,p2=m[2].p;
+	uint64_t p01=(uint64_t)p0*p1;
+	//the constants are stored in Montgomery representation, so multiplying by them gives a standard result
+	uint32_t inv0Mod1=internal_nttPow(&m[1],internal_nttToMontgomery(&m[1],p0%p1),p1-2);
+	uint32_t inv01Mod2=internal_nttPow(&m[2],internal_nttToMontgomery(&m[2],(uint32_t)(p01%p2)),p2-2);
+	uint32_t p0Mod2=internal_nttToMontgomery(&m[2],p0%p2);
+	//the carry has at most 55 bits, the sum of carry and coefficient is stored in three 32bit words
+	uint64_t carryLow=0,carryHigh=0;
+	size_t k=0;
+	for(size_t i=0;i<an+bn;i++){
+		Limb value=0;
+		for(int s=0;s<NTT_PIECES;s++,k++){
+			uint64_t c0=0,c1=0,c2=0;
+			if(k<n){
+				uint32_t x0=residues[0][k];
+				uint32_t x1=internal_nttMul(&m[1],internal_nttSub(&m[1],residues[1][k],x0%p1),inv0Mod1);
+				uint32_t x2=internal_nttSub(&m[2],residues[2][k],
+						internal_nttAdd(&m[2],x0%p2,internal_nttMul(&m[2],x1,p0Mod2)));
+				x2=internal_nttMul(&m[2],x2,inv01Mod2);
+				//x0+x1*p0 < 2^59, x2*p0*p1 < 2^87
+				uint64_t low=x0+(uint64_t)x1*p0;
+				uint64_t prodLow=(uint64_t)x2*(uint32_t)p01,prodHigh=(uint64_t)x2*(p01>>32);
+				c0=(low&0xffffffff)+(prodLow&0xffffffff);
+				c1=(low>>32)+(prodLow>>32)+(prodHigh&0xffffffff);
+				c2=prodHigh>>32;
+			}
+			c0+=carryLow;
+			c1+=carryHigh+(c0>>32);
+			c2+=c1>>32;
+			value|=((Limb)(c0&0xffffffff))<<(32*s);
+			carryLow=c1&0xffffffff;
+			carryHigh=c2;
+		}
+		target[i]=value;
+	}
+	assert(carryLow==0&&carryHigh==0);
+	internal_releaseBlock(context,scratch,capacity);
+	return true;
 }
 
-static void updateSize(BigInt* anInt){
-	anInt->size--;//offset by one to remove the -1 in array access
-	while((anInt->size!=SIZE_MAX)&&(anInt->data[anInt->size]==0)){
-		anInt->size--;
+//target[0..2n)=a*a, target must not overlap a,
+//returns false if the scratch memory could not be allocated
+static bool internal_sqrInto(Limb* target,const Limb* a,size_t n){
+	if(n<=KARATSUBA_SQR_THRESHOLD){
+		internal_sqrBasecase(target,a,n);
+		return true;
+	}
+	if(internal_useNtt(n,n,true)){
+		return internal_nttMulInto(target,a,n,a,n);
+	}
+	if(internal_useToom4(n,n,true)){
+		return internal_toom4(target,a,n,a,n);
+	}
+	if(internal_useToom3(n,n,true)){
+		return internal_toom3(target,a,n,a,n);
+	}
+	BigIntContext* context=internal_currentContext;
+	size_t capacity=internal_roundCapacity(internal_karatsubaScratch(n,KARATSUBA_SQR_THRESHOLD));
+	Limb* scratch=internal_allocBlock(context,capacity);
+	if(!scratch){
+		return false;
+	}
+	internal_karatsubaSqrN(target,a,n,scratch);
+	internal_releaseBlock(context,scratch,capacity);
+	return true;
+}
+//target[0..an+bn)=a*b for an>=2*bn, target must not overlap a or b,
+//a is cut into parts of bn ints which are multiplied with b by the balanced algorithms,
+//the products are added at their offset, returns false if an allocation failed
+static bool internal_mulUnbalanced(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	BigIntContext* context=internal_currentContext;
+	size_t capacity=internal_roundCapacity(2*bn);
+	Limb* product=internal_allocBlock(context,capacity);
+	if(!product){
+		return false;
+	}
+	bool ok=internal_mulInto(target,a,bn,b,bn);
+	for(size_t offset=bn;ok&&offset<an;offset+=bn){
+		size_t partN=an-offset<bn?an-offset:bn;
+		ok=internal_mulInto(product,a+offset,partN,b,bn);
+		//target[offset..offset+bn) contains the upper half of the previous product
+		Limb carry=internal_addN(target+offset,target+offset,product,bn);
+		carry=internal_add1(target+offset+bn,product+bn,partN,carry);
+		assert(carry==0);
+		(void)carry;
+	}
+	internal_releaseBlock(context,product,capacity);
+	return ok;
+}
+//target[0..an+bn)=a*b for an,bn>=1, target must not overlap a or b,
+//selects the algorithm from the sizes of the factors,
+//returns false if the scratch memory could not be allocated
+static bool internal_mulInto(Limb* target,const Limb* a,size_t an,const Limb* b,size_t bn){
+	if(an<bn){
+		const Limb* tmp=a;
+		a=b;
+		b=tmp;
+		size_t tmpN=an;
+		an=bn;
+		bn=tmpN;
+	}
+	if(a==b&&an==bn){
+		return internal_sqrInto(target,a,an);
+	}
+	if(bn<=KARATSUBA_THRESHOLD){
+		internal_mulBasecase(target,a,an,b,bn);
+		return true;
+	}
+	if(internal_useNtt(an,bn,false)){
+		return internal_nttMulInto(target,a,an,b,bn);
+	}
+	if(an>=2*bn){
+		return internal_mulUnbalanced(target,a,an,b,bn);
+	}
+	if(internal_useToom4(an,bn,false)){
+		return internal_toom4(target,a,an,b,bn);
+	}
+	if(internal_useToom3(an,bn,false)){
+		return internal_toom3(target,a,an,b,bn);
+	}
+	if(internal_useToom32(an,bn)){
+		return internal_toom32(target,a,an,b,bn);
 	}
-	anInt->size++;//remove offset
+	return internal_karatsubaInto(target,a,an,b,bn);
 }
-//Multiplies big and small with the Karatsuba multiplication algorithm,
+//the algorithm used by internal_mulInto for factors with an>=bn ints
+static ProfileBranch internal_mulBranch(size_t an,size_t bn,bool square){
+	if(square){
+		return an<=KARATSUBA_SQR_THRESHOLD?BRANCH_SQUARE_SCHOOLBOOK:internal_useNtt(an,bn,true)?BRANCH_SQUARE_NTT:
+			internal_useToom4(an,bn,true)?BRANCH_SQUARE_TOOM4:
+			internal_useToom3(an,bn,true)?BRANCH_SQUARE_TOOM3:BRANCH_SQUARE_KARATSUBA;
+	}
+	return bn<=KARATSUBA_THRESHOLD?BRANCH_MULT_SCHOOLBOOK:internal_useNtt(an,bn,false)?BRANCH_MULT_NTT:
+		an>=2*bn?BRANCH_MULT_UNBALANCED:internal_useToom4(an,bn,false)?BRANCH_MULT_TOOM4:
+		internal_useToom3(an,bn,false)?BRANCH_MULT_TOOM3:
+		internal_useToom32(an,bn)?BRANCH_MULT_TOOM32:BRANCH_MULT_KARATSUBA;
+}
+//Multiplies big and small with the Karatsuba or Toom-Cook multiplication algorithm (depending on the size),
 //neither big nor small is modified in the calculation
 //assumptions big,small !=NULL, big>small>0
 static BigInt* internal_karatsubaMult(BigInt* big,BigInt* small){
-	//printf("Debug: K-mult: %p->%p, %p->%p\n",big,big->data,small,small->data);
-	size_t half=big->size/2;
-	BigInt* res=NULL;
-	BigInt* bigH=malloc(sizeof(BigInt));
-	BigInt* bigL=malloc(sizeof(BigInt));
-	if(bigH&&bigL){
-		bigH->sgn=bigL->sgn=0;
-		bigL->data=big->data;
-		bigL->size=half;
-		updateSize(bigL);
-		bigH->data=big->data+half;
-		bigH->size=big->size-half;
-		if(half<small->size){
-			BigInt* smallH=malloc(sizeof(BigInt));
-			BigInt* smallL=malloc(sizeof(BigInt));
-			if(smallH&&smallL){
-				smallH->sgn=smallL->sgn=0;
-				smallL->data=small->data;
-				smallL->size=half;
-				updateSize(smallL);
-				smallH->data=small->data+half;
-				smallH->size=small->size-half;
-				BigInt* high=multBigInt(bigH,false,smallH,false);
-				if(high){
-					BigInt* low=multBigInt(bigL,false,smallL,false);
-					if(low){
-						BigInt* mid=multBigInt(addBigInt(bigH,false,bigL,false),true,
-								addBigInt(smallH,false,smallL,false),true);
-						mid=subtBigInt(mid,true,high,false);
-						mid=subtBigInt(mid,true,low,false);
-						assert(mid->sgn==0);
-						//assert(mid->sgn==0);
-						res=createBigIntSize(high->size+2*half+1);
-						if(mid&&res){
-							memcpy(res->data,low->data,low->size*sizeof(uint32_t));
-							assert(low->size<=2*half);
-							memset(res->data+low->size,0,(2*half-low->size)*sizeof(uint32_t));
-							freeBigInt(low);
-							low=NULL;
-							memcpy(res->data+2*half,high->data,high->size*sizeof(uint32_t));
-							freeBigInt(high);
-							high=NULL;
-							res->data[res->size-1]=0;//overflow block
-							//addLater addWithOffset?
-							uint64_t buffer=0;
-							size_t i=0;
-							for(;i<mid->size;i++){
-								buffer+=((uint64_t)mid->data[i])+res->data[i+half];
-								res->data[i+half]=buffer&UINT32_MAX;
-								buffer >>= INT_BITS;
-							}
-							freeBigInt(mid);
-							mid=NULL;
-							if(buffer){
-								i+=half;
-								for(;i<res->size;i++){
-									buffer+=res->data[i];
-									res->data[i]=buffer&UINT32_MAX;
-									buffer >>= INT_BITS;
-									if(!buffer)
-										break;
-								}
-								assert(buffer==0);
-							}
-						}else{
-							freeBigInt(high);
-							freeBigInt(low);
-							freeBigInt(mid);
-							freeBigInt(res);
-							high=low=mid=res=NULL;
-						}
-					}else{
-						freeBigInt(high);
-						high=NULL;
-					}
-				}
-			}
-			smallH->data=smallL->data=NULL;//no need to free ->data since it is still bound to the original arguments
-			free(smallH);
-			smallH=NULL;
-			free(smallL);
-			smallL=NULL;
-		}else{
-			BigInt* high=multBigInt(bigH,false,small,false);
-			if(high){
-				BigInt* low=multBigInt(bigL,false,small,false);
-				res=createBigIntSize(high->size+half+1);
-				if(low&&res){
-					memcpy(res->data,low->data,low->size*sizeof(uint32_t));
-					memset(res->data+low->size,0,(res->size-low->size)*sizeof(uint32_t));
-					freeBigInt(low);
-					low=NULL;
-					res->data[res->size-1]=0;//overflow block
-					//addLater addWithOffset?
-					uint64_t buffer=0;
-					size_t i=0;
-					for(;i<high->size;i++){
-						buffer+=((uint64_t)high->data[i])+res->data[i+half];
-						res->data[i+half]=buffer&UINT32_MAX;
-						buffer >>= INT_BITS;
-					}
-					freeBigInt(high);
-					high=NULL;
-					if(buffer){
-						i+=half;
-						buffer+=res->data[i];
-						res->data[i]=buffer&UINT32_MAX;
-						buffer >>= INT_BITS;
-						assert(buffer==0);
-					}
-				}else{
-					freeBigInt(high);
-					freeBigInt(low);
-					freeBigInt(res);
-					high=low=res=NULL;
-				}
-			}
-		}
+	BigInt* res=createBigIntSize(big->size+small->size);
+	if(!res){
+		return NULL;
+	}
+	if(!internal_mulInto(res->data,big->data,big->size,small->data,small->size)){
+		freeBigInt(res);
+		return NULL;
+	}
+	res->sgn=big->sgn^small->sgn;
+	return internal_standardizeBigInt(res);
+}
+
+/**squares a, if consume is true a will be deleted by the calculation*/
+static BigInt* internal_squareBigInt(BigInt* a,bool consume){
+	consume=consume&&internal_canConsume(a);
+	if(!a){
+		return NULL;
+	}
+	if(a->size==0){
+		return consume?a:createBigIntInt(0);
+	}
+	internal_profileBranch(internal_mulBranch(a->size,a->size,true));
+	//the square cannot be computed in place, so the memory of a is not reused
+	BigInt* res=createBigIntSize(2*a->size);
+	if(res&&!internal_sqrInto(res->data,a->data,a->size)){
+		freeBigInt(res);
+		res=NULL;
 	}
-	bigH->data=bigL->data=NULL;//no need to free ->data since it is still bound to the original arguments
-	free(bigH);
-	bigH=NULL;
-	free(bigL);
-	bigL=NULL;
-	if(res){
-		res->sgn=big->sgn^small->sgn;
+	if(consume){
+		freeBigInt(a);
 	}
 	return internal_standardizeBigInt(res);
 }
 
 /**multiples a by b
   arguments marked with consume will be deleted or overwritten by the calculation*/
-BigInt* multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+static BigInt* internal_multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	consumeA=consumeA&&internal_canConsume(a);
+	consumeB=consumeB&&internal_canConsume(b);
 	if(a&&b){
-		if(a==b){//can only consume one
-			consumeA&=consumeB;//only consume if both can be consumed
-			consumeB=false;
-			//addLater call squareBigInt here
+		if(a==b){//only consume if both can be consumed
+			return internal_squareBigInt(a,consumeA&&consumeB);
 		}
 		if(a->size==0){//one of the factors is 0
 			if(consumeB){
@@ -1339,7 +4422,8 @@ BigInt* multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 				consumeB=!consumeB;
 			}
 		}//len a>=len b
-		if (a->size > KARATSUBA_THRESHOLD){
+		if (b->size > KARATSUBA_THRESHOLD){
+			internal_profileBranch(internal_mulBranch(a->size,b->size,false));
 			BigInt* ret=internal_karatsubaMult(a,b);
 			if(consumeA){
 				freeBigInt(a);
@@ -1350,10 +4434,12 @@ BigInt* multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 			return ret;
 		}
 		if(consumeA){
-			uint32_t* tmpP=realloc(a->data,(a->size+b->size)*sizeof(uint32_t));
-			if(tmpP){
-				a->data=tmpP;
-				tmp=a;
+			tmp=internal_reserve(a,a->size+b->size);
+			if(tmp){
+				if(b==a){//a may have been moved
+					b=tmp;
+				}
+				a=tmp;
 			}else{
 				freeBigInt(a);
 				if(consumeB){
@@ -1363,10 +4449,9 @@ BigInt* multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 			}
 		}else{
 			if(consumeB){
-				uint32_t* tmpP=realloc(b->data,(a->size+b->size)*sizeof(uint32_t));
-				if(tmpP){
-					b->data=tmpP;
-					tmp=b;
+				tmp=internal_reserve(b,a->size+b->size);
+				if(tmp){
+					b=tmp;
 					consumeB=false;//b should not be deleted
 				}else{
 					freeBigInt(b);
@@ -1379,6 +4464,7 @@ BigInt* multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 				}
 			}
 		}
+		internal_profileBranch(BRANCH_MULT_SCHOOLBOOK);
 		internal_unsaveMult(tmp,a,b);
 		if(consumeB){
 			freeBigInt(b);
@@ -1388,14 +4474,80 @@ BigInt* multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 	}
 	return NULL;
 }
+BigInt* multBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_MULT,internal_operandSize(a,b));
+	BigInt* res=internal_multBigInt(a,consumeA,b,consumeB);
+	internal_leaveOp(scope);
+	return res;
+}
 
 BigInt* squareBigInt(BigInt* a,bool consume){
-	//TODO special handling for squaring
-	return multBigInt(a,consume,a,consume);
+	OperationScope scope=internal_enterOp(BIG_INT_OP_SQUARE,internal_operandSize(a,NULL));
+	BigInt* res=internal_squareBigInt(a,consume);
+	internal_leaveOp(scope);
+	return res;
+}
+
+/*stores a*b in dst, reusing the memory of dst*/
+BigInt* multBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	if(!(a&&b)){
+		freeBigInt(dst);
+		return NULL;
+	}
+	if(a->size<b->size){//len a>=len b
+		BigInt* tmp=a;
+		a=b;
+		b=tmp;
+	}
+	if(b->size==0){
+		dst=internal_prepareInto(dst,0,NULL,NULL);
+		if(dst){
+			dst->size=0;
+			dst->sgn=0;
+		}
+		return dst;
+	}
+	if(a==b){
+		if(a==dst){//the square cannot be computed in place
+			return internal_moveInto(dst,squareBigInt(a,false));
+		}
+		internal_profileBranch(internal_mulBranch(a->size,a->size,true));
+		dst=internal_prepareInto(dst,2*a->size,NULL,NULL);
+		if(dst&&!internal_sqrInto(dst->data,a->data,a->size)){
+			freeBigInt(dst);
+			return NULL;
+		}
+		if(dst){
+			dst->size=2*a->size;
+			dst->sgn=0;
+		}
+		return internal_standardizeBigInt(dst);
+	}
+	bool karatsuba=b->size>KARATSUBA_THRESHOLD;
+	if(karatsuba&&(a==dst||b==dst)){
+		//the Karatsuba and Toom-Cook multiplications cannot write into their arguments
+		return internal_moveInto(dst,multBigInt(a,false,b,false));
+	}
+	dst=internal_prepareInto(dst,a->size+b->size,&a,&b);
+	if(dst==NULL){
+		return NULL;
+	}
+	internal_profileBranch(internal_mulBranch(a->size,b->size,false));
+	if(karatsuba){
+		if(!internal_mulInto(dst->data,a->data,a->size,b->data,b->size)){
+			freeBigInt(dst);
+			return NULL;
+		}
+		dst->size=a->size+b->size;
+		dst->sgn=a->sgn^b->sgn;
+	}else{
+		internal_unsaveMult(dst,a,b);
+	}
+	return internal_standardizeBigInt(dst);
 }
 
-static uint32_t internal_divBigIntInt(BigInt* a,uint32_t div){
-	uint64_t tmp=0;
+static Limb internal_divBigIntInt(BigInt* a,Limb div){
+	DoubleLimb tmp=0;
 	if(div!=1){
 		for(size_t i=a->size-1;i!=SIZE_MAX;i--){
 			tmp <<= INT_BITS;
@@ -1404,7 +4556,48 @@ static uint32_t internal_divBigIntInt(BigInt* a,uint32_t div){
 			tmp%=div;
 		}
 	}
-	return tmp&UINT32_MAX;
+	return tmp&LIMB_MAX;
+}
+
+//divides |a| by the span b[0..bn) (bn>=2, b[bn-1]!=0) with the schoolbook division,
+//a is consumed and reused for the remainder, the quotient is stored in q if q is not NULL,
+//assumes |a|>=|b| and that a is standardized,
+//returns the remainder or NULL if an allocation failed
+static BigInt* internal_divModSchoolbook(BigInt* a,const Limb* b,size_t bn,BigInt** q){
+	size_t an=a->size;
+	int shift=internal_leadingZeros(b[bn-1]);
+	//normalize: both numbers are shifted such that the highest bit of the divisor is set,
+	//the divisor is copied first since b may be the data of a
+	BigInt* divisor=createBigIntSize(bn);
+	if(divisor){
+		if(shift!=0){
+			internal_lshift(divisor->data,b,bn,shift);
+		}else{
+			internal_copy(divisor->data,b,bn);
+		}
+	}
+	BigInt* tmp=divisor?internal_reserve(a,an+1):NULL;
+	BigInt* quot=(tmp&&q)?createBigIntSize(an-bn+1):NULL;
+	if(!tmp||(q&&!quot)){
+		freeBigInt(divisor);
+		freeBigInt(tmp?tmp:a);
+		if(q){
+			*q=NULL;
+		}
+		return NULL;
+	}
+	a=tmp;
+	a->data[an]=shift!=0?internal_lshift(a->data,a->data,an,shift):0;
+	internal_divRemBasecase(quot?quot->data:NULL,a->data,an,divisor->data,bn);
+	freeBigInt(divisor);
+	if(shift!=0){
+		internal_rshift(a->data,a->data,bn,shift);
+	}
+	a->size=bn;
+	if(q){
+		*q=internal_standardizeBigInt(quot);
+	}
+	return internal_standardizeBigInt(a);
 }
 
 //divides a by b using the Newton-algorithm
@@ -1412,14 +4605,15 @@ static uint32_t internal_divBigIntInt(BigInt* a,uint32_t div){
 static BigInt* internal_divideNewton(BigInt* a,BigInt* b){
 	size_t k=a->size;
 	BigInt* res=shiftBigInt(
-			createBigIntInt(0x1000000000LL / b->data[b->size - 1]), true,
+			internal_createBigIntDoubleLimb((((DoubleLimb)1) << (INT_BITS + 4)) / b->data[b->size - 1]), true,
 			INT_BITS * (a->size - b->size));
 	//uses Newton-Method on
 	//X_(i+1)=X_i+(X_i(2^k-D*X_i))/2^k
 	//to calculate an estimate for 2^k/D
 	BigInt* del;
-	uint32_t sgnBuff;
+	Limb sgnBuff;
 	while(1){
+		internal_profileBranch(BRANCH_DIV_NEWTON_ITERATIONS);
 		del=multBigInt(b,false,res,false);//D*X_i
 		//addLater? more effective creation method for 2^(32k)
 		del = subtBigInt(shiftBigInt(createBigIntInt(1), true, (INT_BITS * k) + 4),
@@ -1446,7 +4640,9 @@ static BigInt* internal_divideNewton(BigInt* a,BigInt* b){
 
 /**divides a by b
   arguments marked with consume will be deleted or overwritten by the calculation*/
-DivModResult divModBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB,bool storeDiv,bool storeRem){
+static DivModResult internal_divModBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB,bool storeDiv,bool storeRem){
+	consumeA=consumeA&&internal_canConsume(a);
+	consumeB=consumeB&&internal_canConsume(b);
 	if(a&&b&&(storeDiv||storeRem)){
 		if(a==b){//can only consume one
 			consumeA&=consumeB;//only consume if both can be consumed
@@ -1489,16 +4685,17 @@ DivModResult divModBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB,bool s
 		}
 		BigInt* q=NULL;
 		if(b->size==1){
-			uint32_t rem=internal_divBigIntInt(a,b->data[0]);
+			internal_profileBranch(BRANCH_DIV_SINGLE_INT);
+			Limb rem=internal_divBigIntInt(a,b->data[0]);
 			if(storeDiv){
 				q=internal_standardizeBigInt(a);//store result in q
 			}else{
-				free(a);
+				freeBigInt(a);
 				a=NULL;
 			}
 			if(storeRem){
 				if(!consumeB){
-					b=createBigIntInt(rem);
+					b=internal_createBigIntDoubleLimb(rem);
 				}else{
 					b->data[0]=rem;
 					consumeB=false;
@@ -1515,140 +4712,44 @@ DivModResult divModBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB,bool s
 				lnzB--;
 			assert((a->data[lnzA]!=0)&&(b->data[lnzB]!=0));
 			delta=lnzA-lnzB;
-			if(true/*lnzA>20||delta>10*/){//TODO constants
+			if(lnzB>0&&(lnzB<NEWTON_DIV_THRESHOLD||delta<NEWTON_DIV_THRESHOLD)){
+				internal_profileBranch(BRANCH_DIV_LONG);
 				a->size=lnzA+1;
-				b->size=lnzB+1;
-				if(storeRem){
-					q=cloneBigInt(a);
-				}
-				a=internal_divideNewton(a,b);
-				//FIXME correct error +-1
-				if(storeRem){
-					BigInt* tmp=a;
-					a=subtBigInt(q,true,multBigInt(a,false,b,consumeB),true);
-					consumeB=false;
-					q=tmp;
-				}else if(storeDiv){
-					q=a;
-					a=NULL;
+				a=internal_divModSchoolbook(a,b->data,lnzB+1,storeDiv?&q:NULL);
+				if(!a){
+					if(consumeB){
+						freeBigInt(b);
+					}
+					return (DivModResult){.result=NULL,.remainder=NULL};
 				}
 			}else{
-				uint64_t div,remBuffer=0,divBuffer;
-				if(storeDiv){
-					q=createBigIntSize(delta+2);
-					if(q==NULL||q->data==NULL){
-						//creating q failed
-						freeBigInt(a);
-						if(consumeB){
-							freeBigInt(b);
-						}
-						return (DivModResult){.result=NULL,.remainder=NULL};
-					}else{
-						//initialize bits of return value to 0
-						memset(q->data,0,(delta+2)*sizeof(uint32_t));
-					}
+				internal_profileBranch(BRANCH_DIV_NEWTON);
+				a->size=lnzA+1;
+				BigInt* rem=cloneBigInt(a);
+				q=internal_divideNewton(a,b);
+				//the Newton-approximation can be off by a small amount,
+				//correct q such that the remainder is between 0 and b-1
+				rem=subtBigInt(rem,true,multBigInt(q,false,b,false),true);
+				while(rem&&q&&rem->sgn){
+					rem=addBigInt(rem,true,b,false);
+					q=subtBigInt(q,true,BIG_INT_ONE,false);
 				}
-				while(lnzA>=lnzB){//>=0 not possible for uints
-					div=a->data[lnzA];
-					while(div<=b->data[lnzB]){
-						if(lnzA>lnzB){
-							div <<= INT_BITS;
-							delta--;
-							div|=a->data[lnzA-1];
-						}else{
-							delta=SIZE_MAX;
-							break;
-						}
-					}
-					if(delta==SIZE_MAX){
-						break;
-					}
-					div/=(b->data[lnzB]+1);
-					if(div>0){
-						if(storeDiv){
-							divBuffer=div;
-							divBuffer+=q->data[delta];
-							q->data[delta]=divBuffer&UINT32_MAX;
-							divBuffer >>= INT_BITS;
-							size_t i=1;
-							while(divBuffer!=0){
-								divBuffer+=q->data[delta+i];
-								q->data[delta+i]=divBuffer&UINT32_MAX;
-								divBuffer >>= INT_BITS;
-								i++;
-							}
-						}
-						divBuffer=0;
-						for(size_t i=0;i<=lnzB;i++){
-							remBuffer+=a->data[i+delta];
-							remBuffer&=UINT32_MAX;
-							divBuffer+=div*b->data[i];
-							remBuffer-=divBuffer&UINT32_MAX;
-							a->data[i+delta]=remBuffer&UINT32_MAX;
-							remBuffer >>= INT_BITS;
-							divBuffer >>= INT_BITS;
-						}
-						if((remBuffer!=0||divBuffer!=0)&&lnzA==delta+lnzB+1){
-							remBuffer+=a->data[lnzA];
-							remBuffer&=UINT32_MAX;
-							remBuffer-=divBuffer&UINT32_MAX;
-							a->data[lnzA]=remBuffer&UINT32_MAX;
-							remBuffer >>= INT_BITS;
-							divBuffer >>= INT_BITS;
-						}
-					}
-					assert(remBuffer==0&&divBuffer==0);
-					while(lnzA>0&& a->data[lnzA]==0){
-						lnzA--;
-					}
-					delta=lnzA-lnzB;
+				while(rem&&q&&cmpBigInt(rem,b)>=0){
+					rem=subtBigInt(rem,true,b,false);
+					q=addBigInt(q,true,BIG_INT_ONE,false);
 				}
-				if(lnzA==SIZE_MAX){
-					a->size=0;
-					free(a->data);
-					a->data=NULL;
-				}else{
-					//adjust size for compare
-					a->size=lnzA+1;
-					if(cmpBigInt(a,b)>=0){
-						//TODO? extract common code to function?
-						for(size_t i=0;i<=lnzB;i++){
-							remBuffer+=a->data[i];
-							remBuffer&=UINT32_MAX;
-							remBuffer-=b->data[i];
-							a->data[i]=remBuffer&UINT32_MAX;
-							remBuffer >>= INT_BITS;
-						}
-						assert(remBuffer==0);
-						while(lnzA>0&& a->data[lnzA]==0){
-							lnzA--;
-						}
-						if(storeDiv){
-							q->data[0]++;
-						}
-					}
-					//readjusts size
-					a->size=lnzA+1;
-					if(lnzA==0&&a->data[lnzA]==0){
-						a->size=0;
-						free(a->data);
-						a->data=NULL;
-					}else{
-						//reduce size of data block
-						uint32_t* tmp=realloc(a->data,a->size*sizeof(uint32_t));
-						if(tmp){
-							a->data=tmp;
-						}else{
-							//reallocation of a failed
-							freeBigInt(a);
-							freeBigInt(q);
-							return (DivModResult){.result=NULL,.remainder=NULL};
-						}
+				if(!(rem&&q)){
+					freeBigInt(rem);
+					freeBigInt(q);
+					if(consumeB){
+						freeBigInt(b);
 					}
-					q=internal_standardizeBigInt(q);
+					return (DivModResult){.result=NULL,.remainder=NULL};
 				}
+				a=rem;
 			}
 		}else{
+			internal_profileBranch(BRANCH_DIV_SMALL_DIVIDEND);
 			if(storeDiv){
 				q=createBigIntInt(0);
 			}
@@ -1693,6 +4794,12 @@ DivModResult divModBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB,bool s
 	}
 	return (DivModResult){.result=NULL,.remainder=NULL};
 }
+DivModResult divModBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB,bool storeDiv,bool storeRem){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_DIVMOD,internal_operandSize(a,b));
+	DivModResult res=internal_divModBigInt(a,consumeA,b,consumeB,storeDiv,storeRem);
+	internal_leaveOp(scope);
+	return res;
+}
 /**divides a by b
   arguments marked with consume will be deleted or overwritten by the calculation*/
 BigInt* divBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
@@ -1704,7 +4811,85 @@ BigInt* modBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 	return divModBigInt(a,consumeA,b,consumeB,false,true).remainder;
 }
 
-BigInt* bigIntGCD(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+//remainder of |a| divided by div, a is not modified
+static Limb internal_modBigIntInt(BigInt* a,Limb div){
+	DoubleLimb tmp=0;
+	for(size_t i=a->size-1;i!=SIZE_MAX;i--){
+		tmp <<= INT_BITS;
+		tmp+=a->data[i];
+		tmp%=div;
+	}
+	return tmp&LIMB_MAX;
+}
+/**stores the result of a divided by b in q and the remainder in r, reusing the memory of q and r,
+ * q and r have to be different numbers (or NULL)*/
+DivModResult divModBigIntInto(BigInt* q,BigInt* r,BigInt* a,BigInt* b){
+	if(a&&b&&b->size==1){//divisor fits in one int: divide the copy of a in place
+		Limb div=b->data[0],sgnA=a->sgn,sgnB=b->sgn;
+		q=copyBigIntInto(q,a);
+		if(q==NULL){
+			freeBigInt(r);
+			return (DivModResult){.result=NULL,.remainder=NULL};
+		}
+		Limb rem=internal_divBigIntInt(q,div);
+		q->sgn=sgnA^sgnB;
+		q=internal_standardizeBigInt(q);
+		r=internal_prepareInto(r,1,NULL,NULL);
+		if(r==NULL){
+			freeBigInt(q);
+			return (DivModResult){.result=NULL,.remainder=NULL};
+		}
+		r->data[0]=rem;
+		r->size=1;
+		r->sgn=sgnA;
+		r=internal_standardizeBigInt(r);
+		return (DivModResult){.result=q,.remainder=r};
+	}
+	DivModResult res=divModBigInt(a,false,b,false,true,true);
+	if(!(res.result&&res.remainder)){
+		freeBigInt(res.result);
+		freeBigInt(res.remainder);
+		freeBigInt(q);
+		freeBigInt(r);
+		return (DivModResult){.result=NULL,.remainder=NULL};
+	}
+	res.result=internal_moveInto(q,res.result);
+	res.remainder=internal_moveInto(r,res.remainder);
+	return res;
+}
+/*stores the result of a divided by b in dst, reusing the memory of dst*/
+BigInt* divBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	if(a&&b&&b->size==1){
+		Limb div=b->data[0],sgn=a->sgn^b->sgn;
+		dst=copyBigIntInto(dst,a);
+		if(dst){
+			internal_divBigIntInt(dst,div);
+			dst->sgn=sgn;
+			dst=internal_standardizeBigInt(dst);
+		}
+		return dst;
+	}
+	return internal_moveInto(dst,divBigInt(a,false,b,false));
+}
+/*stores the remainder of a divided by b in dst, reusing the memory of dst*/
+BigInt* modBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	if(a&&b&&b->size==1){
+		Limb rem=internal_modBigIntInt(a,b->data[0]),sgn=a->sgn;
+		dst=internal_prepareInto(dst,1,NULL,NULL);
+		if(dst){
+			dst->data[0]=rem;
+			dst->size=1;
+			dst->sgn=sgn;
+			dst=internal_standardizeBigInt(dst);
+		}
+		return dst;
+	}
+	return internal_moveInto(dst,modBigInt(a,false,b,false));
+}
+
+static BigInt* internal_bigIntGCD(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	consumeA=consumeA&&internal_canConsume(a);
+	consumeB=consumeB&&internal_canConsume(b);
 	if(a&&b){
 		if(a==b){//can only consume one
 			consumeA&=consumeB;//only consume if both can be consumed
@@ -1768,17 +4953,25 @@ BigInt* bigIntGCD(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 	}
 	return NULL;
 }
+BigInt* bigIntGCD(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_GCD,internal_operandSize(a,b));
+	BigInt* res=internal_bigIntGCD(a,consumeA,b,consumeB);
+	internal_leaveOp(scope);
+	return res;
+}
 
 /**returns a to the power of b
   arguments marked with consume will be deleted or overwritten by the calculation*/
-BigInt* powBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+static BigInt* internal_powBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	consumeA=consumeA&&internal_canConsume(a);
+	consumeB=consumeB&&internal_canConsume(b);
 	if(a&&b){
 		if(a==b){//can only consume one
 			consumeA&=consumeB;//only consume if both can be consumed
 			consumeB=false;
 		}
 		uint64_t pow;
-		if((b->sgn)||(b->size>2)){
+		if((b->sgn)||(b->size*INT_BITS>64)){
 			if(consumeA){
 				freeBigInt(a);
 			}//no else
@@ -1797,9 +4990,11 @@ BigInt* powBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 				return createBigIntInt(1);
 			}else{
 				pow=b->data[0];
+#ifndef BIG_INT_64BIT_LIMBS
 				if(b->size==2){
 					pow |= ((uint64_t) b->data[1]) << INT_BITS;
 				}
+#endif
 			}
 			if(consumeB){
 				freeBigInt(b);
@@ -1810,24 +5005,42 @@ BigInt* powBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
 		if(!consumeA){
 			a=cloneBigInt(a);
 		}
-		if(res){
-			while(pow!=0){
-				if(pow&1){
-					res=multBigInt(res,true,a,false);
-					if(!res){
-						freeBigInt(a);
-						return NULL;
-					}
-				}
-				pow>>=1;
-				a=squareBigInt(a,true);
-				if(!a){
-					freeBigInt(res);
+		if(!(res&&a)){
+			freeBigInt(res);
+			freeBigInt(a);
+			return NULL;
+		}
+		while(true){
+			if(pow&1){
+				res=multBigInt(res,true,a,false);
+				if(!res){
+					freeBigInt(a);
 					return NULL;
 				}
 			}
+			pow>>=1;
+			if(pow==0){//the last square is not needed
+				break;
+			}
+			a=squareBigInt(a,true);
+			if(!a){
+				freeBigInt(res);
+				return NULL;
+			}
 		}
+		freeBigInt(a);
 		return res;
 	}
 	return NULL;
 }
+BigInt* powBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB){
+	OperationScope scope=internal_enterOp(BIG_INT_OP_POW,internal_operandSize(a,NULL));
+	BigInt* res=internal_powBigInt(a,consumeA,b,consumeB);
+	internal_leaveOp(scope);
+	return res;
+}
+
+/*stores a to the power of b in dst*/
+BigInt* powBigIntInto(BigInt* dst,BigInt* a,BigInt* b){
+	return internal_moveInto(dst,powBigInt(a,false,b,false));
+}
@@ -8,6 +8,19 @@
 #ifndef BIGINT_H_
 #define BIGINT_H_
 
+/* Thread safety:
+ * - different numbers can be used by different threads at the same time
+ * - a number can be read by multiple threads at the same time (as argument that is not consumed),
+ *   but it must not be consumed or freed while another thread uses it
+ * - BIG_INT_ZERO and BIG_INT_ONE can be used by all threads
+ * - the current context, the memory block cache and all scratch buffers are local to each thread,
+ *   an arena must only be used by one thread at a time
+ * - the cache of powers used for string conversions is shared without locks,
+ *   it must not be trimmed or freed while other threads convert numbers
+ * - the global settings (bigIntSetConversionThreads, bigIntSetCacheLimit, bigIntSetKernels) can be changed at any time
+ * - the algorithm thresholds (bigIntSetThreshold) must only be changed while no other thread uses BigInts
+ */
+
 #include <stdio.h>
 #include <stdint.h>
 #include <stdbool.h>
@@ -19,30 +32,249 @@ typedef struct {
 	BigInt* remainder;
 }DivModResult;
 
+/**allocator used for the memory of BigInts,
+ * every number remembers the context it was created with and uses it for all later (re-)allocations,
+ * so a number can be used (and freed) after the current context has been changed*/
+typedef struct BigIntContextStruct{
+	//returns a new memory block of size bytes, or NULL if the allocation failed
+	void* (*allocate)(void* userData,size_t size);
+	//resizes the block ptr with oldSize bytes to newSize bytes, returns the (possibly moved) block,
+	//or NULL if the allocation failed (ptr stays valid in that case)
+	void* (*reallocate)(void* userData,void* ptr,size_t oldSize,size_t newSize);
+	//releases the block ptr with the given size
+	void (*release)(void* userData,void* ptr,size_t size);
+	//passed as first argument to all functions of this context
+	void* userData;
+}BigIntContext;
+typedef struct BigIntArenaStruct BigIntArena;
+
 //constants for zero and one
-//!!! do not mark this values as consumable!!!
-BigInt* BIG_INT_ZERO;
-BigInt* BIG_INT_ONE;
+//the constants are never modified or freed, even if they are passed as consumable argument
+extern BigInt* const BIG_INT_ZERO;
+extern BigInt* const BIG_INT_ONE;
 
 
 //creates a BigInt from a 64bit int value
 BigInt* createBigIntInt(int64_t value);
 /*creates a BigInt from a null-terminated string
- *base should be between 2 and 62*///XXX describe case handling
+ *base should be between 2 and 62, a leading '-' marks a negative number*///XXX describe case handling
 BigInt* createBigIntCStr(const char* str,int base);
 /*creates a BigInt from a string
- *base should be between 2 and 62*///XXX describe case handling
+ *base should be between 2 and 62, a leading '-' marks a negative number*///XXX describe case handling
 BigInt* createBigIntStr(const char* stringValue,size_t stringLen,int base);
-/**creates a BigInt from the given array of bytes*/
-BigInt* createBigIntBytes(void* bytes,size_t numBytes);
+
+//flags for the byte-array conversion functions, one byte order and one sign flag can be combined with |
+//bytes are ordered from the least to the most significant byte
+#define BIG_INT_BYTES_LITTLE_ENDIAN 0
+//bytes are ordered from the most to the least significant byte
+#define BIG_INT_BYTES_BIG_ENDIAN 1
+//bytes contain the absolute value of the number
+#define BIG_INT_BYTES_UNSIGNED 0
+//bytes contain the two-complement representation of the number
+#define BIG_INT_BYTES_TWOS_COMPLEMENT 2
+
+/**creates a BigInt from the given array of bytes,
+ * flags determines the byte-order and sign handling of the input*/
+BigInt* createBigIntBytes(const void* bytes,size_t numBytes,int flags);
+/**creates a BigInt from the given array of 32bit integers (least significant int first),
+ * sgn should be 0 for non-negative and UINT32_MAX for negative numbers,
+ * the BigInt takes ownership of value (which has to be allocated with malloc),
+ * if BigInt.c is compiled with BIG_INT_64BIT_LIMBS the ints are copied and value is freed*/
+BigInt* createBigIntInts(uint32_t sgn,uint32_t* value,size_t size);
 /**creates a clone of the given BigInteger*/
 BigInt* cloneBigInt(BigInt* source);
 /**frees the given BigInteger*/
 void freeBigInt(BigInt* toFree);
 
+/**sets the context used to allocate the numbers created by the calling thread,
+ * NULL selects the default context (malloc), returns the previous context*/
+BigIntContext* bigIntSetContext(BigIntContext* context);
+/**returns the context used by the calling thread, NULL if the thread uses the default context*/
+BigIntContext* bigIntGetContext(void);
+/**creates an arena that allocates memory in blocks of (at least) blockSize bytes,
+ * numbers created with the context of an arena are freed all at once by resetting the arena,
+ * an arena must only be used by one thread at a time,
+ * returns NULL if the allocation failed*/
+BigIntArena* createBigIntArena(size_t blockSize);
+/**returns the context allocating from arena*/
+BigIntContext* bigIntArenaContext(BigIntArena* arena);
+/**releases all numbers allocated from arena at once,
+ * the memory blocks of the arena are kept and reused for later allocations*/
+void bigIntArenaReset(BigIntArena* arena);
+/**frees the arena and all numbers allocated from it*/
+void freeBigIntArena(BigIntArena* arena);
+
+typedef struct{
+	//number of allocations that reused a cached memory block
+	size_t hits;
+	//number of allocations of cacheable size that needed a new memory block
+	size_t misses;
+	//number of bytes currently kept in the cache
+	size_t retainedBytes;
+}BigIntCacheStats;
+/**sets the maximum number of bytes each thread keeps in its cache of unused memory blocks
+ * (the default is 4 MiB), 0 disables the cache*/
+void bigIntSetCacheLimit(size_t maxBytes);
+/**returns the statistics of the memory block cache of the calling thread*/
+BigIntCacheStats bigIntCacheStats(void);
+/**frees all memory blocks cached by the calling thread,
+ * this is done automatically when a thread terminates*/
+void bigIntReleaseThreadCache(void);
+
+//the public operations, used to attribute the memory statistics to the operation that caused them
+typedef enum{
+	//everything outside of the operations below (creating, cloning and freeing numbers, ...)
+	BIG_INT_OP_OTHER,
+	//createBigIntStr, createBigIntCStr
+	BIG_INT_OP_PARSE,
+	//bigIntToString, bigIntToStringAlloc
+	BIG_INT_OP_TO_STRING,
+	BIG_INT_OP_PRINT,
+	BIG_INT_OP_NOT,
+	BIG_INT_OP_AND,
+	BIG_INT_OP_OR,
+	BIG_INT_OP_XOR,
+	BIG_INT_OP_SHIFT,
+	BIG_INT_OP_NEGATE,
+	BIG_INT_OP_ADD,
+	BIG_INT_OP_SUBT,
+	BIG_INT_OP_MULT,
+	BIG_INT_OP_SQUARE,
+	//divModBigInt, divBigInt, modBigInt
+	BIG_INT_OP_DIVMOD,
+	BIG_INT_OP_GCD,
+	BIG_INT_OP_POW,
+	BIG_INT_OP_COUNT
+}BigIntOperation;
+/**name of the function corresponding to op*/
+const char* bigIntOperationName(BigIntOperation op);
+
+typedef struct{
+	//number of allocated, resized and released memory blocks of numbers and scratch buffers
+	size_t allocations;
+	size_t reallocations;
+	size_t frees;
+	//number of bytes currently allocated
+	size_t liveBytes;
+	//sum of the maximum number of bytes allocated by each thread
+	//(an upper bound for the maximum of the whole program, exact if only one thread is used)
+	size_t peakBytes;
+	//number of allocations (including reallocations) and allocated bytes during each operation,
+	//if operations call each other everything is attributed to the outermost operation
+	size_t opAllocations[BIG_INT_OP_COUNT];
+	size_t opBytes[BIG_INT_OP_COUNT];
+}BigIntMemoryStats;
+/**enables or disables the memory statistics (disabled by default),
+ * numbers allocated while the statistics are disabled are not counted when they are released,
+ * numbers released by resetting an arena are not counted*/
+void bigIntEnableMemoryStats(bool enable);
+/**returns the memory statistics summed over all threads
+ * (including the threads that have terminated)*/
+BigIntMemoryStats bigIntMemoryStats(void);
+/**sets all counters except liveBytes to zero, the peak is set to the current number of live bytes,
+ * should only be called while no other thread uses BigInts*/
+void bigIntResetMemoryStats(void);
+
+/* Profiling: if BigInt.c is compiled with BIG_INT_PROFILE defined (-DBIG_INT_PROFILE),
+ * every call of a public operation (including calls made by other operations) counts
+ * the number of calls, the time spent in the operation (including the time of nested operations),
+ * a histogram of the operand sizes (in ints, characters for createBigIntStr)
+ * and the algorithms selected by the operations (e.g. Karatsuba or schoolbook multiplication).
+ * Without BIG_INT_PROFILE nothing is measured. */
+#define BIG_INT_PROFILE_TEXT 0
+#define BIG_INT_PROFILE_JSON 1
+/**writes the profiling data of all threads to target in the given format (BIG_INT_PROFILE_TEXT or BIG_INT_PROFILE_JSON),
+ * returns false if BigInt.c was compiled without BIG_INT_PROFILE*/
+bool bigIntWriteProfile(FILE* target,int format);
+/**sets all profiling counters to zero,
+ * should only be called while no other thread uses BigInts*/
+void bigIntResetProfile(void);
+
+/**selects the implementation of the low level add, subtract and multiply kernels:
+ * "portable" (plain C) or "adx" (x86-64 with BMI2 and ADX, needs BIG_INT_64BIT_LIMBS),
+ * NULL selects the fastest implementation supported by the CPU (the default),
+ * returns false if the implementation is not available (the selection is not changed in that case)*/
+bool bigIntSetKernels(const char* name);
+/**name of the kernels used by the arithmetic operations*/
+const char* bigIntKernels(void);
+
+//sizes at which the operations switch to asymptotically faster algorithms,
+//the defaults can be replaced at compile time by defining BIG_INT_<NAME>_THRESHOLD (e.g. -DBIG_INT_TOOM3_THRESHOLD=250)
+//or by compiling with BIG_INT_TUNED, which includes the header BigIntThresholds.h generated by Tune.c
+typedef enum{
+	//ints of the smaller factor above which products are computed with the Karatsuba algorithm
+	BIG_INT_THRESHOLD_KARATSUBA,
+	//ints above which squares are computed with the Karatsuba algorithm
+	BIG_INT_THRESHOLD_KARATSUBA_SQR,
+	//ints of the smaller factor (of the number for squares) from which the Toom-Cook algorithms are used
+	BIG_INT_THRESHOLD_TOOM3,
+	BIG_INT_THRESHOLD_TOOM3_SQR,
+	BIG_INT_THRESHOLD_TOOM4,
+	BIG_INT_THRESHOLD_TOOM4_SQR,
+	//ints of the smaller factor from which the unbalanced Toom-3.2 algorithm is used
+	BIG_INT_THRESHOLD_TOOM32,
+	//ints of the smaller factor (of the number for squares) from which number theoretic transforms are used
+	BIG_INT_THRESHOLD_NTT,
+	BIG_INT_THRESHOLD_NTT_SQR,
+	//ints of the divisor and the quotient from which the Newton division is used
+	BIG_INT_THRESHOLD_NEWTON_DIV,
+	//digits above which strings are parsed with the divide and conquer algorithm
+	BIG_INT_THRESHOLD_PARSE_DC,
+	//ints from which the conversion to a string is split between multiple threads
+	BIG_INT_THRESHOLD_PARALLEL_PRINT,
+	BIG_INT_THRESHOLD_COUNT
+}BigIntThreshold;
+/**name of the threshold (e.g. "karatsuba" for BIG_INT_THRESHOLD_KARATSUBA)*/
+const char* bigIntThresholdName(BigIntThreshold threshold);
+/**sets the value of threshold, 0 restores the compiled default,
+ * returns false if threshold does not exist or value is below the smallest supported value
+ * (the threshold is not changed in that case)*/
+bool bigIntSetThreshold(BigIntThreshold threshold,size_t value);
+/**current value of threshold, 0 if threshold does not exist*/
+size_t bigIntThreshold(BigIntThreshold threshold);
+
+/**ensures that a can store numbers with up to capacity ints without reallocation
+ * (32bit ints, or 64bit ints if BigInt.c is compiled with BIG_INT_64BIT_LIMBS),
+ * returns a or NULL if the allocation failed (in that case a is not modified)*/
+BigInt* bigIntReserve(BigInt* a,size_t capacity);
+/**releases memory that a has reserved but currently does not use, returns a*/
+BigInt* bigIntShrinkToFit(BigInt* a);
+
 int printBigInt(BigInt *toPrint, _Bool consume, FILE *target, int base);
+/**upper bound for the number of chars needed to convert a to a string in the given base,
+ * including the sign and the terminating null-character, returns 0 for invalid bases*/
+size_t bigIntStringSize(BigInt* a,int base);
+/**writes a in the given base as null-terminated string to buffer,
+ * bufferSize has to be at least bigIntStringSize(a,base),
+ * returns the length of the string or 0 if the conversion failed
+  arguments marked with consume will be deleted or overwritten by the calculation*/
+size_t bigIntToString(BigInt* a,bool consume,char* buffer,size_t bufferSize,int base);
+/**converts a to a null-terminated string in the given base,
+ * the string is allocated with malloc and has to be freed by the caller,
+ * returns NULL if the conversion failed
+  arguments marked with consume will be deleted or overwritten by the calculation*/
+char* bigIntToStringAlloc(BigInt* a,bool consume,int base);
+/**sets the maximum number of threads used to convert a single large number to a string,
+ * the default is 1 (no additional threads)*/
+void bigIntSetConversionThreads(int numThreads);
+/**releases all but the first keep cached powers of base used for string conversions,
+ * base 0 trims the caches of all bases,
+ * the cache must not be trimmed while other threads are converting numbers*/
+void bigIntTrimPowerCache(int base,int keep);
+/**releases all cached powers used for string conversions,
+ * the cache must not be released while other threads are converting numbers*/
+void bigIntFreePowerCache(void);
 void printBigIntHex(BigInt* number,bool consume);
 
+/**number of bytes needed to store a in the format given by flags*/
+size_t bigIntByteLength(BigInt* a,int flags);
+/**writes a into target in the format given by flags,
+ * returns the number of bytes needed to store a,
+ * if this is larger than targetLen nothing is written to target,
+ * otherwise the remaining bytes of target are filled with the (sign-extended) value.
+ * In the unsigned format the absolute value of a is stored*/
+size_t bigIntBytes(BigInt* a,void* target,size_t targetLen,int flags);
+
 
 /**returns the sign of a (a<0?-1:a>0?1:0)*/
 int bigIntSgn(BigInt* a);
@@ -109,4 +341,42 @@ BigInt* bigIntGCD(BigInt* a,bool consumeA,BigInt* b,bool consumeB);
   arguments marked with consume will be deleted or overwritten by the calculation*/
 BigInt* powBigInt(BigInt* a,bool consumeA,BigInt* b,bool consumeB);
 
+/* Destination-passing variants:
+ * the result is stored in dst, reusing the memory dst has already reserved,
+ * so loops that reuse their numbers (see bigIntReserve) do not need new allocations.
+ * - dst can be the same number as a or b (or both), a and b are not modified otherwise
+ * - if dst is NULL or one of the constants a new number is created
+ * - the result may be moved to a new address, the returned pointer replaces dst,
+ *   if the calculation fails dst is freed and NULL is returned
+ * Karatsuba multiplication with dst equal to a or b, division by numbers with more than one int and pow
+ * use temporary numbers internally, in that case the memory of dst is released*/
+
+/**copies the value of src into dst*/
+BigInt* copyBigIntInto(BigInt* dst,BigInt* src);
+/**stores the logical and of a and b in dst*/
+BigInt* andBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores the logical or of a and b in dst*/
+BigInt* orBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores the logical exclusive or of a and b in dst*/
+BigInt* xorBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores a shifted by the given amount in dst,
+ * if amount is positive a is shifted to the left otherwise to the right*/
+BigInt* shiftBigIntInto(BigInt* dst,BigInt* a,int64_t amount);
+/**stores a+b in dst*/
+BigInt* addBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores a-b in dst*/
+BigInt* subtBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores a*b in dst*/
+BigInt* multBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores the result of a divided by b in q and the remainder in r,
+ * q and r have to be different numbers (or NULL),
+ * returns the new values of q and r, both are NULL if the calculation failed*/
+DivModResult divModBigIntInto(BigInt* q,BigInt* r,BigInt* a,BigInt* b);
+/**stores the result of a divided by b in dst*/
+BigInt* divBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores the remainder of a divided by b in dst*/
+BigInt* modBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+/**stores a to the power of b in dst*/
+BigInt* powBigIntInto(BigInt* dst,BigInt* a,BigInt* b);
+
 #endif /* BIGINT_H_ */
@@ -849,7 +849,29 @@ static BigInt* evaluateTree(TreeNode* tree){
 	return NULL;
 }
 
-int main(void) {
+//prints the memory statistics of the last expression
+static void printMemoryStats(void){
+	BigIntMemoryStats stats=bigIntMemoryStats();
+	printf("Memory: %zu allocations, %zu reallocations, %zu frees, %zu bytes live, %zu bytes peak\n",
+			stats.allocations,stats.reallocations,stats.frees,stats.liveBytes,stats.peakBytes);
+	for(int op=0;op<BIG_INT_OP_COUNT;op++){
+		if(stats.opAllocations[op]>0){
+			printf("  %-16s %8zu allocations %10zu bytes\n",bigIntOperationName(op),stats.opAllocations[op],stats.opBytes[op]);
+		}
+	}
+}
+
+//the option -m prints the memory statistics after each expression
+int main(int argc,char** argv) {
+	bool memoryStats=argc>1&&strcmp(argv[1],"-m")==0;
+	if(memoryStats){
+		bigIntEnableMemoryStats(true);
+	}
+	//all numbers of an expression are allocated in an arena that is reset after the expression is evaluated
+	BigIntArena* arena=createBigIntArena(1<<16);
+	if(arena){
+		bigIntSetContext(bigIntArenaContext(arena));
+	}
 	for(int i=0;i<16;i++){
 		fputs("\n> ",stdout);
 		fflush(stdout);
@@ -857,6 +879,7 @@ int main(void) {
 		if(line){
 			if(line->length==1&&(strcmp(line->strings[0].chars,"exit")==0)){
 				freeStringArray(line);
+				freeBigIntArena(arena);
 				return EXIT_SUCCESS;
 			}
 			TreeNode *tree = parse(line);
@@ -875,9 +898,15 @@ int main(void) {
 			}else{
 				puts("parsing error");
 			}
+			if(memoryStats){
+				printMemoryStats();
+				bigIntResetMemoryStats();
+			}
 			fflush(stdout);
+			bigIntArenaReset(arena);
 		}
 	}
+	freeBigIntArena(arena);
 	fputs("\n> exit\n ",stdout);
 	return EXIT_SUCCESS;
 }
@@ -0,0 +1,329 @@
+/*
+ * Tune.c
+ *
+ * measures the sizes at which the faster algorithms of BigInt.c overtake the simpler ones on the current machine,
+ * the measured values are written to the header BigIntThresholds.h (the path can be passed as argument),
+ * compiling BigInt.c with BIG_INT_TUNED (-DBIG_INT_TUNED) uses them as default thresholds,
+ * Tune.c has to be compiled with the same configuration as BigInt.c (for instance BIG_INT_64BIT_LIMBS)
+ *
+ * Author: bsoelch
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "BigInt.h"
+
+#ifdef BIG_INT_64BIT_LIMBS
+static const size_t INT_BYTES = 8;
+#else
+static const size_t INT_BYTES = 4;
+#endif
+//every measurement is the best of this many rounds, each round runs for at least MIN_ROUND_TIME seconds
+static const int ROUNDS = 3;
+static const double MIN_ROUND_TIME = 0.01;
+//the size is increased by this factor between two measurements
+static const double SIZE_STEP = 1.15;
+//the faster algorithm has to win by this factor at this many sizes in a row
+static const double WIN_FACTOR = 0.98;
+static const int WINS_NEEDED = 3;
+//value that keeps an algorithm from being selected while the simpler algorithms are tuned
+static const size_t DISABLED = SIZE_MAX/4;
+
+//operands of the measured operation
+static BigInt* opA;
+static BigInt* opB;
+static char* opString;
+static size_t opStringLen;
+
+typedef struct{
+	BigIntThreshold threshold;
+	//name of the macro in the generated header
+	const char* macro;
+	//range of the searched operand sizes
+	size_t minSize;
+	size_t maxSize;
+	//the faster algorithm is used for operands of size n if the threshold is at most n-offset
+	size_t offset;
+	//creates the operands for size n
+	void (*prepare)(size_t n);
+	//runs the operation once on the prepared operands
+	void (*run)(void);
+	//the operation uses multiple threads and is measured in wall clock time instead of the cpu time of the thread
+	bool threads;
+}Tuning;
+
+static double currentTime(bool wallClock){
+	struct timespec time;
+	clock_gettime(wallClock?CLOCK_MONOTONIC:CLOCK_THREAD_CPUTIME_ID,&time);
+	return time.tv_sec+time.tv_nsec*1e-9;
+}
+//a pseudo-random number with exactly the given number of ints
+static BigInt* randomValue(size_t ints){
+	static uint64_t state=0x9e3779b97f4a7c15ULL;
+	size_t numBytes=ints*INT_BYTES;
+	unsigned char* bytes=malloc(numBytes);
+	if(!bytes){
+		return NULL;
+	}
+	for(size_t i=0;i<numBytes;i++){
+		state^=state<<13;
+		state^=state>>7;
+		state^=state<<17;
+		bytes[i]=(unsigned char)state;
+	}
+	bytes[numBytes-1]|=0x80;
+	BigInt* ret=createBigIntBytes(bytes,numBytes,BIG_INT_BYTES_LITTLE_ENDIAN|BIG_INT_BYTES_UNSIGNED);
+	free(bytes);
+	return ret;
+}
+static void freeOperands(void){
+	freeBigInt(opA);
+	freeBigInt(opB);
+	free(opString);
+	opA=NULL;
+	opB=NULL;
+	opString=NULL;
+}
+
+static void prepareMult(size_t n){
+	opA=randomValue(n);
+	opB=randomValue(n);
+}
+static void prepareSquare(size_t n){
+	opA=randomValue(n);
+}
+//the larger factor is 1.75 times as long as the smaller one
+static void prepareUnbalanced(size_t n){
+	opA=randomValue(n+3*n/4);
+	opB=randomValue(n);
+}
+//dividend with 2n ints, divisor and quotient with n ints
+static void prepareDivide(size_t n){
+	opA=randomValue(2*n);
+	opB=randomValue(n);
+}
+static void prepareParse(size_t n){
+	opString=malloc(n);
+	if(opString){
+		for(size_t i=0;i<n;i++){
+			opString[i]=(char)('1'+(i*7)%9);
+		}
+	}
+	opStringLen=n;
+}
+static void preparePrint(size_t n){
+	opA=randomValue(n);
+}
+static void runMult(void){
+	freeBigInt(multBigInt(opA,false,opB,false));
+}
+static void runSquare(void){
+	freeBigInt(squareBigInt(opA,false));
+}
+static void runDivide(void){
+	freeBigInt(divBigInt(opA,false,opB,false));
+}
+static void runParse(void){
+	freeBigInt(createBigIntStr(opString,opStringLen,10));
+}
+static void runPrint(void){
+	free(bigIntToStringAlloc(opA,false,10));
+}
+
+//the thresholds in the order they are tuned,
+//each algorithm is compared to the simpler algorithms that are already tuned
+static const Tuning TUNINGS[]={
+		{BIG_INT_THRESHOLD_KARATSUBA,"BIG_INT_KARATSUBA_THRESHOLD",8,400,1,&prepareMult,&runMult,false},
+		{BIG_INT_THRESHOLD_KARATSUBA_SQR,"BIG_INT_KARATSUBA_SQR_THRESHOLD",8,600,1,&prepareSquare,&runSquare,false},
+		{BIG_INT_THRESHOLD_TOOM3,"BIG_INT_TOOM3_THRESHOLD",60,3000,0,&prepareMult,&runMult,false},
+		{BIG_INT_THRESHOLD_TOOM3_SQR,"BIG_INT_TOOM3_SQR_THRESHOLD",60,3000,0,&prepareSquare,&runSquare,false},
+		{BIG_INT_THRESHOLD_TOOM32,"BIG_INT_TOOM32_THRESHOLD",40,3000,0,&prepareUnbalanced,&runMult,false},
+		{BIG_INT_THRESHOLD_TOOM4,"BIG_INT_TOOM4_THRESHOLD",200,6000,0,&prepareMult,&runMult,false},
+		{BIG_INT_THRESHOLD_TOOM4_SQR,"BIG_INT_TOOM4_SQR_THRESHOLD",200,6000,0,&prepareSquare,&runSquare,false},
+		{BIG_INT_THRESHOLD_NTT,"BIG_INT_NTT_THRESHOLD",1000,120000,0,&prepareMult,&runMult,false},
+		{BIG_INT_THRESHOLD_NTT_SQR,"BIG_INT_NTT_SQR_THRESHOLD",1000,120000,0,&prepareSquare,&runSquare,false},
+		//the division compares the index of the highest int with the threshold,
+		//the crossover is around 30000 32bit ints and 60000 64bit ints
+		{BIG_INT_THRESHOLD_NEWTON_DIV,"BIG_INT_NEWTON_DIV_THRESHOLD",1000,100000,1,&prepareDivide,&runDivide,false},
+		{BIG_INT_THRESHOLD_PARSE_DC,"BIG_INT_PARSE_DC_THRESHOLD",100,50000,1,&prepareParse,&runParse,false},
+		{BIG_INT_THRESHOLD_PARALLEL_PRINT,"BIG_INT_PARALLEL_PRINT_THRESHOLD",100,20000,0,&preparePrint,&runPrint,true},
+};
+static const size_t TUNING_COUNT=sizeof(TUNINGS)/sizeof(Tuning);
+
+//seconds per call of the operation of tuning, each round repeats it until at least MIN_ROUND_TIME seconds have passed
+static double timeRound(const Tuning* tuning){
+	int iterations=0;
+	double start=currentTime(tuning->threads),time;
+	do{
+		tuning->run();
+		iterations++;
+		time=currentTime(tuning->threads)-start;
+	}while(time<MIN_ROUND_TIME);
+	return time/iterations;
+}
+//searches the smallest size from which the faster algorithm of tuning wins WINS_NEEDED times in a row,
+//returns 0 if it does not win up to the maximum size
+static size_t tuneThreshold(const Tuning* tuning){
+	size_t streakStart=0;
+	int wins=0;
+	for(size_t n=tuning->minSize;n<=tuning->maxSize;n=n*SIZE_STEP>n+1?(size_t)(n*SIZE_STEP):n+1){
+		tuning->prepare(n);
+		double simple=1e30,fast=1e30;
+		//the rounds of both algorithms alternate to reduce the influence of changing machine load
+		for(int r=0;r<ROUNDS;r++){
+			bigIntSetThreshold(tuning->threshold,n-tuning->offset+1);
+			double time=timeRound(tuning);
+			simple=time<simple?time:simple;
+			bigIntSetThreshold(tuning->threshold,n-tuning->offset);
+			time=timeRound(tuning);
+			fast=time<fast?time:fast;
+		}
+		freeOperands();
+		printf("  %8zu %14.2f %14.2f\n",n,simple*1e6,fast*1e6);
+		if(fast<simple*WIN_FACTOR){
+			if(wins++==0){
+				streakStart=n;
+			}
+			if(wins==WINS_NEEDED){
+				return streakStart;
+			}
+		}else{
+			wins=0;
+		}
+	}
+	return 0;
+}
+
+//values[i] is the measured threshold of TUNINGS[i], 0 if it was not measured,
+//lowerBounds[i] is not 0 if the faster algorithm did not win up to that size
+static bool writeHeader(const char* path,const size_t* values,const size_t* lowerBounds){
+	FILE* file=fopen(path,"w");
+	if(!file){
+		return false;
+	}
+	fprintf(file,"/*\n * BigIntThresholds.h\n *\n * generated by Tune.c for %zubit ints,\n",INT_BYTES*8);
+	fprintf(file," * compiling BigInt.c with BIG_INT_TUNED uses these values as default thresholds\n */\n\n");
+	fprintf(file,"#ifndef BIGINT_THRESHOLDS_H_\n#define BIGINT_THRESHOLDS_H_\n\n");
+#ifdef BIG_INT_64BIT_LIMBS
+	fprintf(file,"#ifndef BIG_INT_64BIT_LIMBS\n#error \"the thresholds were measured with BIG_INT_64BIT_LIMBS\"\n#endif\n\n");
+#else
+	fprintf(file,"#ifdef BIG_INT_64BIT_LIMBS\n#error \"the thresholds were measured without BIG_INT_64BIT_LIMBS\"\n#endif\n\n");
+#endif
+	for(size_t i=0;i<TUNING_COUNT;i++){
+		if(values[i]){
+			fprintf(file,"#define %s %zu\n",TUNINGS[i].macro,values[i]);
+		}else if(lowerBounds[i]){
+			fprintf(file,"//%s: no crossover up to %zu, the threshold is at least %zu, the default value is used\n",
+					TUNINGS[i].macro,TUNINGS[i].maxSize,lowerBounds[i]);
+		}else{
+			fprintf(file,"//%s not measured, the default value is used\n",TUNINGS[i].macro);
+		}
+	}
+	fprintf(file,"\n#endif /* BIGINT_THRESHOLDS_H_ */\n");
+	return fclose(file)==0;
+}
+
+//sets threshold to the smallest value accepted by bigIntSetThreshold
+static void setSmallestThreshold(BigIntThreshold threshold){
+	size_t value=1;
+	while(!bigIntSetThreshold(threshold,value)){
+		value++;
+	}
+}
+//the tuning sets the thresholds to arbitrary values, so the squares and products of all sizes up to CHECK_SIZE ints
+//are compared with the schoolbook results while each threshold (and the Karatsuba thresholds) has its smallest value,
+//returns false if a result differs
+static const size_t CHECK_SIZE = 64;
+static bool checkSmallestThresholds(void){
+	bool ok=true;
+	for(int t=0;t<BIG_INT_THRESHOLD_COUNT;t++){
+		for(size_t n=1;n<=CHECK_SIZE;n++){
+			BigInt* a=randomValue(n);
+			BigInt* b=randomValue(n);
+			for(int u=0;u<BIG_INT_THRESHOLD_COUNT;u++){
+				bigIntSetThreshold(u,DISABLED);
+			}
+			BigInt* square=multBigInt(a,false,cloneBigInt(a),true);
+			BigInt* product=multBigInt(a,false,b,false);
+			for(int u=0;u<BIG_INT_THRESHOLD_COUNT;u++){
+				bigIntSetThreshold(u,0);
+			}
+			setSmallestThreshold(BIG_INT_THRESHOLD_KARATSUBA);
+			setSmallestThreshold(BIG_INT_THRESHOLD_KARATSUBA_SQR);
+			setSmallestThreshold(t);
+			BigInt* fastSquare=squareBigInt(a,false);
+			BigInt* fastProduct=multBigInt(a,false,b,false);
+			if(cmpBigInt(square,fastSquare)!=0||cmpBigInt(product,fastProduct)!=0){
+				printf("wrong result for %zu ints with the smallest %s threshold\n",n,bigIntThresholdName(t));
+				ok=false;
+			}
+			freeBigInt(a);
+			freeBigInt(b);
+			freeBigInt(square);
+			freeBigInt(product);
+			freeBigInt(fastSquare);
+			freeBigInt(fastProduct);
+		}
+	}
+	for(int u=0;u<BIG_INT_THRESHOLD_COUNT;u++){
+		bigIntSetThreshold(u,0);
+	}
+	return ok;
+}
+
+int main(int argc,char** argv){
+	const char* path=argc>1?argv[1]:"BigIntThresholds.h";
+	int numThreads=(int)sysconf(_SC_NPROCESSORS_ONLN);
+	bigIntSetConversionThreads(numThreads);
+	printf("tuning for %zubit ints, kernels: %s\n",INT_BYTES*8,bigIntKernels());
+	if(!checkSmallestThresholds()){
+		return 1;
+	}
+	//the multiplication thresholds are tuned from the simplest algorithm upwards
+	for(size_t i=0;i<TUNING_COUNT;i++){
+		if(TUNINGS[i].run==&runMult||TUNINGS[i].run==&runSquare){
+			bigIntSetThreshold(TUNINGS[i].threshold,DISABLED);
+		}
+	}
+	size_t values[sizeof(TUNINGS)/sizeof(Tuning)];
+	size_t lowerBounds[sizeof(TUNINGS)/sizeof(Tuning)];
+	for(size_t i=0;i<TUNING_COUNT;i++){
+		const Tuning* tuning=&TUNINGS[i];
+		const char* name=bigIntThresholdName(tuning->threshold);
+		values[i]=0;
+		lowerBounds[i]=0;
+		if(tuning->threshold==BIG_INT_THRESHOLD_PARALLEL_PRINT&&numThreads<2){
+			printf("%s: not measured on a single core\n",name);
+			continue;
+		}
+		printf("%s:\n  %8s %14s %14s\n",name,"size","simple [us]","fast [us]");
+		size_t size=tuneThreshold(tuning);
+		if(size==0){
+			//the faster algorithm only pays off above the searched sizes, the default is kept in the header,
+			//the remaining tunings use the lower bound if it is above the default
+			lowerBounds[i]=tuning->maxSize-tuning->offset;
+			bigIntSetThreshold(tuning->threshold,0);
+			size_t defaultValue=bigIntThreshold(tuning->threshold);
+			if(defaultValue<lowerBounds[i]){
+				bigIntSetThreshold(tuning->threshold,lowerBounds[i]);
+			}
+			printf("%s: no crossover up to %zu, the default %zu is kept\n",name,tuning->maxSize,defaultValue);
+			continue;
+		}
+		values[i]=size-tuning->offset;
+		bigIntSetThreshold(tuning->threshold,values[i]);
+		printf("%s = %zu\n",name,values[i]);
+	}
+	if(!writeHeader(path,values,lowerBounds)){
+		printf("could not write %s\n",path);
+		return 1;
+	}
+	printf("thresholds written to %s\n",path);
+	bigIntFreePowerCache();
+	return 0;
+}